@@ -0,0 +1,87 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace alp {
+
+Arena::Arena(size_t blockSize, std::pmr::memory_resource *upstream) :
+	_upstream(upstream), _nextSize(std::max<size_t>(blockSize, 64)) {}
+
+Arena::Arena(void *buffer, size_t size, std::pmr::memory_resource *upstream) :
+	_upstream(upstream),
+	_initial(static_cast<char *>(buffer)),
+	_initialSize(size),
+	_nextSize(std::max<size_t>(size, 4096)) {
+	reset();
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment) {
+	for (;;) {
+		const uintptr_t p = (uintptr_t(_p) + alignment - 1) & ~(alignment - 1);
+		if (_p && p <= uintptr_t(_end) && bytes <= uintptr_t(_end) - p) {
+			_p = reinterpret_cast<char *>(p + bytes);
+			return reinterpret_cast<void *>(p);
+		}
+
+		// move on to the next block kept from before the last reset, if it fits
+		Block *next = _current ? _current->next : _head;
+		if (!next || next->size < bytes + alignment) {
+			const size_t size = std::max(_nextSize, bytes + alignment);
+			Block *      b    = static_cast<Block *>(
+				_upstream->allocate(sizeof(Block) + size, alignof(std::max_align_t)));
+			b->size = size;
+			b->next = next;
+			if (_current)
+				_current->next = b;
+			else
+				_head = b;
+			next       = b;
+			_capacity += size;
+			_nextSize  = std::min<size_t>(_nextSize * 2, size_t(1) << 24);
+		}
+		_current = next;
+		_p       = next->data();
+		_end     = _p + next->size;
+	}
+}
+
+void Arena::release() {
+	for (Block *b = _head; b;) {
+		Block *next = b->next;
+		_upstream->deallocate(
+			b, sizeof(Block) + b->size, alignof(std::max_align_t));
+		b = next;
+	}
+	_head     = nullptr;
+	_capacity = 0;
+	reset();
+}
+
+std::string_view Arena::copy(std::string_view s) {
+	char *res = static_cast<char *>(allocate(s.size() + 1, 1));
+	if (!s.empty()) std::memcpy(res, s.data(), s.size());
+	res[s.size()] = 0;
+	return {res, s.size()};
+}
+
+} // namespace alp
@@ -0,0 +1,94 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_ARENA_HPP
+#define ALPHA4_COMMON_ARENA_HPP
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+
+namespace alp {
+
+// Bump pointer allocator for short lived scratch memory, usable wherever a
+// std::pmr::memory_resource is accepted. Deallocation is a no-op; reset()
+// makes all memory available again in O(1) while keeping the blocks obtained
+// from upstream, so a steady state workload stops allocating after warm-up.
+// An optional initial buffer, e.g. on the stack, is used before any block.
+//
+// Not thread-safe.
+class Arena : public std::pmr::memory_resource {
+protected:
+	struct Block {
+		Block *next;
+		size_t size;
+
+		char *data() { return reinterpret_cast<char *>(this + 1); }
+	};
+
+	std::pmr::memory_resource *_upstream;
+
+	// owned blocks, in the order they are used; _current is null while the
+	// initial buffer is in use
+	Block *_head    = nullptr;
+	Block *_current = nullptr;
+	char * _p = nullptr, *_end = nullptr;
+
+	char * _initial     = nullptr;
+	size_t _initialSize = 0;
+	size_t _nextSize;
+	size_t _capacity = 0;
+
+	void *do_allocate(size_t bytes, size_t alignment) override;
+	void  do_deallocate(void *, size_t, size_t) override {}
+	bool  do_is_equal(const memory_resource &other) const noexcept override {
+		return this == &other;
+	}
+
+public:
+	explicit Arena(
+		size_t                     blockSize = 4096,
+		std::pmr::memory_resource *upstream  = std::pmr::get_default_resource());
+	Arena(
+		void *                     buffer,
+		size_t                     size,
+		std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+	~Arena() { release(); }
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	// Rewinds to the start of the initial buffer, or the first block.
+	void reset() {
+		_current = nullptr;
+		_p       = _initial;
+		_end     = _initial + _initialSize;
+	}
+
+	// Returns all blocks to upstream.
+	void release();
+
+	// Bytes obtained from upstream.
+	size_t capacity() const { return _capacity; }
+
+	std::pmr::memory_resource *upstream() const { return _upstream; }
+
+	// Null terminated copy of s, valid until the next reset.
+	std::string_view copy(std::string_view s);
+};
+
+} // namespace alp
+#endif
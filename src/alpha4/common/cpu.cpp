@@ -0,0 +1,132 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "cpu.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define ALPHA4_CPU_X86 1
+#endif
+
+namespace alp {
+namespace {
+
+CpuFeatures detect() {
+	CpuFeatures res;
+#ifdef ALPHA4_CPU_X86
+	unsigned a, b, c, d;
+	if (!__get_cpuid(1, &a, &b, &c, &d)) return res;
+
+	res.sse2   = d & (1u << 26);
+	res.sse42  = c & (1u << 20);
+	res.popcnt = c & (1u << 23);
+
+	// the OS must save the ymm (bits 1, 2) and zmm/opmask state (bits 5-7)
+	uint64_t xcr0 = 0;
+	if (c & (1u << 27)) {
+		unsigned lo, hi;
+		__asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		xcr0 = (uint64_t(hi) << 32) | lo;
+	}
+	const bool ymm = (xcr0 & 0x06) == 0x06;
+	const bool zmm = (xcr0 & 0xe6) == 0xe6;
+
+	res.avx = ymm && (c & (1u << 28));
+	res.fma = ymm && (c & (1u << 12));
+
+	if (__get_cpuid_count(7, 0, &a, &b, &c, &d)) {
+		res.avx2     = ymm && (b & (1u << 5));
+		res.bmi2     = b & (1u << 8);
+		res.avx512f  = zmm && (b & (1u << 16));
+		res.avx512dq = zmm && (b & (1u << 17));
+		res.avx512bw = zmm && (b & (1u << 30));
+		res.avx512vl = zmm && (b & (1u << 31));
+	}
+#endif
+	return res;
+}
+
+Isa detectIsa() {
+	const CpuFeatures &f = cpuFeatures();
+	if (!f.avx2 || !f.fma) return Isa::Generic;
+	if (f.avx512f && f.avx512dq && f.avx512bw && f.avx512vl) return Isa::AVX512;
+	return Isa::AVX2;
+}
+
+std::atomic<Isa> &active() {
+	static std::atomic<Isa> res([]() {
+		Isa         isa = supportedIsa();
+		const char *env = std::getenv("ALPHA4_ISA");
+		Isa         requested;
+		if (env && parseIsa(env, requested)) isa = std::min(isa, requested);
+		return isa;
+	}());
+	return res;
+}
+
+} // namespace
+
+const CpuFeatures &cpuFeatures() {
+	static const CpuFeatures res = detect();
+	return res;
+}
+
+Isa supportedIsa() {
+	static const Isa res = detectIsa();
+	return res;
+}
+
+Isa activeIsa() { return active().load(std::memory_order_relaxed); }
+
+Isa setActiveIsa(Isa isa) {
+	isa = std::min(isa, supportedIsa());
+	active().store(isa, std::memory_order_relaxed);
+	return isa;
+}
+
+const char *isaName(Isa isa) {
+	switch (isa) {
+		case Isa::Generic:
+	#ifdef ALPHA4_CPU_X86
+			return "sse2";
+	#else
+			return "generic";
+	#endif
+		case Isa::AVX2: return "avx2";
+		case Isa::AVX512: return "avx512";
+	}
+	return "";
+}
+
+bool parseIsa(std::string_view name, Isa &res) {
+	if (name == "generic" || name == "sse2")
+		res = Isa::Generic;
+	else if (name == "avx2")
+		res = Isa::AVX2;
+	else if (name == "avx512")
+		res = Isa::AVX512;
+	else
+		return false;
+	return true;
+}
+
+} // namespace alp
@@ -0,0 +1,63 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_CPU_HPP
+#define ALPHA4_COMMON_CPU_HPP
+#include <cstdint>
+#include <string_view>
+
+namespace alp {
+
+// Instruction set levels the SIMD kernels are compiled for. Generic is the
+// compiler's baseline target, i.e. SSE2 on x86-64. AVX2 implies FMA, AVX512
+// the F, DQ, BW and VL subsets.
+enum class Isa : uint8_t { Generic, AVX2, AVX512 };
+
+struct CpuFeatures {
+	bool sse2     = false;
+	bool sse42    = false;
+	bool popcnt   = false;
+	bool avx      = false;
+	bool avx2     = false;
+	bool fma      = false;
+	bool bmi2     = false;
+	bool avx512f  = false;
+	bool avx512dq = false;
+	bool avx512bw = false;
+	bool avx512vl = false;
+};
+
+// Features reported by CPUID, taking into account whether the operating system
+// saves the extended register state.
+const CpuFeatures &cpuFeatures();
+
+// Highest level supported by the CPU.
+Isa supportedIsa();
+
+// Level the kernels dispatch to. Defaults to supportedIsa(), capped by the
+// ALPHA4_ISA environment variable (generic/sse2, avx2 or avx512) if set.
+Isa activeIsa();
+
+// Changes the active level, e.g. to compare kernels in benchmarks. Levels above
+// supportedIsa() are capped, the level actually set is returned.
+Isa setActiveIsa(Isa isa);
+
+const char *isaName(Isa isa);
+bool        parseIsa(std::string_view name, Isa &res);
+
+} // namespace alp
+#endif
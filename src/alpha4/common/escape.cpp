@@ -0,0 +1,147 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "escape.hpp"
+
+#include <cstdint>
+
+namespace alp {
+
+namespace {
+
+int hexValue(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+// Reads exactly four hex digits at p, -1 if there are none.
+long hex4(const char *p, const char *end) {
+	if (end - p < 4) return -1;
+	long res = 0;
+	for (int i = 0; i < 4; i++) {
+		const int d = hexValue(p[i]);
+		if (d < 0) return -1;
+		res = res * 16 + d;
+	}
+	return res;
+}
+
+char *encodeUtf8(char *out, uint32_t c) {
+	if (c < 0x80) {
+		*out++ = char(c);
+	} else if (c < 0x800) {
+		*out++ = char(0xc0 | (c >> 6));
+		*out++ = char(0x80 | (c & 0x3f));
+	} else if (c < 0x10000) {
+		*out++ = char(0xe0 | (c >> 12));
+		*out++ = char(0x80 | ((c >> 6) & 0x3f));
+		*out++ = char(0x80 | (c & 0x3f));
+	} else {
+		*out++ = char(0xf0 | (c >> 18));
+		*out++ = char(0x80 | ((c >> 12) & 0x3f));
+		*out++ = char(0x80 | ((c >> 6) & 0x3f));
+		*out++ = char(0x80 | (c & 0x3f));
+	}
+	return out;
+}
+
+} // namespace
+
+size_t unescape(std::string_view s, char *out) {
+	const char *p = s.data(), *end = p + s.size();
+	char *      o = out;
+	while (p < end) {
+		const char *q = static_cast<const char *>(
+			std::memchr(p, '\\', size_t(end - p)));
+		if (!q) q = end;
+		// in place the unescaped text trails the input, memmove copes
+		if (o != p) std::memmove(o, p, size_t(q - p));
+		o += q - p;
+		p  = q;
+		if (p >= end) break;
+		if (++p >= end) {
+			// a trailing backslash escapes nothing
+			*o++ = '\\';
+			break;
+		}
+
+		const char c = *p++;
+		switch (c) {
+			case '0': *o++ = '\0'; break;
+			case 'a': *o++ = '\a'; break;
+			case 'b': *o++ = '\b'; break;
+			case 'e': *o++ = '\x1b'; break;
+			case 'f': *o++ = '\f'; break;
+			case 'n': *o++ = '\n'; break;
+			case 'r': *o++ = '\r'; break;
+			case 't': *o++ = '\t'; break;
+			case 'v': *o++ = '\v'; break;
+			case 'x': {
+				int v = p < end ? hexValue(*p) : -1;
+				if (v < 0) {
+					*o++ = 'x';
+					break;
+				}
+				p++;
+				const int d = p < end ? hexValue(*p) : -1;
+				if (d >= 0) {
+					v = v * 16 + d;
+					p++;
+				}
+				*o++ = char(v);
+				break;
+			}
+			case 'u': {
+				long v = hex4(p, end);
+				if (v < 0) {
+					*o++ = 'u';
+					break;
+				}
+				p += 4;
+				if (v >= 0xd800 && v < 0xdc00) {
+					const long low = (end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+						? hex4(p + 2, end)
+						: -1;
+					if (low >= 0xdc00 && low < 0xe000) {
+						v  = 0x10000 + ((v - 0xd800) << 10) + (low - 0xdc00);
+						p += 6;
+					} else
+						v = 0xfffd;
+				} else if (v >= 0xdc00 && v < 0xe000)
+					v = 0xfffd;
+				o = encodeUtf8(o, uint32_t(v));
+				break;
+			}
+			default: *o++ = c; break;
+		}
+	}
+	return size_t(o - out);
+}
+
+std::string_view
+	unescape(std::string_view s, std::pmr::memory_resource &memory) {
+	if (!hasEscapes(s)) return s;
+	char *       res  = static_cast<char *>(memory.allocate(s.size() + 1, 1));
+	const size_t size = unescape(s, res);
+	res[size]         = 0;
+	return {res, size};
+}
+
+} // namespace alp
@@ -0,0 +1,53 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_ESCAPE_HPP
+#define ALPHA4_COMMON_ESCAPE_HPP
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+
+namespace alp {
+
+// Backslash escapes, as left in quoted tokens read with
+// LineScanner::FUSE_ESCAPE. Recognized are \0 \a \b \e \f \n \r \t \v, \xHH
+// with one or two hex digits and \uXXXX, which is encoded as UTF-8 and may be
+// a surrogate pair. Any other escaped character stands for itself, e.g. \\ or
+// \", as do malformed \x and \u sequences. Unescaping never lengthens the
+// text, so it can be done in place.
+
+inline bool hasEscapes(std::string_view s) {
+	return std::memchr(s.data(), '\\', s.size()) != nullptr;
+}
+
+// Writes the unescaped form of s to out, which may be s.data(), and returns
+// its size.
+size_t unescape(std::string_view s, char *out);
+
+// Returns s itself if it contains no escapes, otherwise its unescaped form,
+// NUL terminated, in memory allocated from memory, e.g. an Arena.
+std::string_view
+	unescape(std::string_view s, std::pmr::memory_resource &memory);
+
+inline std::string_view unescapeInPlace(char *data, size_t size) {
+	return {data, unescape({data, size}, data)};
+}
+
+} // namespace alp
+#endif
@@ -0,0 +1,186 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "fastmath.hpp"
+
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <limits>
+
+namespace alp {
+
+// Lanes out of the integer range give 0, as for scalars.
+template<typename T, size_t B> struct PackMathTraits {
+	typedef T                                 scalar;
+	typedef typename simd::Pack<T, B>::index integer;
+	static ALPHA4_SIMD_INLINE void
+		toInt(const simd::pack_t<T, B> &v, integer &res) {
+		const auto in = simd::abs<T, B>(v) < FastMathTraits<T>::limit;
+		res = __builtin_convertvector(in ? v : simd::pack_t<T, B>{}, integer);
+	}
+};
+
+template<>
+struct FastMathTraits<simd::pack_t<float, 32>> : PackMathTraits<float, 32> {};
+template<>
+struct FastMathTraits<simd::pack_t<float, 64>> : PackMathTraits<float, 64> {};
+template<>
+struct FastMathTraits<simd::pack_t<double, 32>> : PackMathTraits<double, 32> {};
+template<>
+struct FastMathTraits<simd::pack_t<double, 64>> : PackMathTraits<double, 64> {};
+
+namespace {
+
+using namespace simd;
+
+enum class TrigOp { Sincos, Sin, Cos, Tan, Atan2 };
+
+// Scalar form of an operation, which falls back to libm where the kernels
+// are not accurate. For Sincos res0/res1 receive sine and cosine, for Atan2
+// in0/in1 are y and x.
+template<typename T, TrigOp Op>
+inline void trigScalar(T in0, T in1, T &res0, T &res1) {
+	if constexpr (Op == TrigOp::Atan2)
+		res0 = fastAtan2(in0, in1);
+	else if constexpr (Op == TrigOp::Sincos)
+		fastSincos(in0, res0, res1);
+	else if constexpr (Op == TrigOp::Sin)
+		res0 = fastSin(in0);
+	else if constexpr (Op == TrigOp::Cos)
+		res0 = fastCos(in0);
+	else
+		res0 = fastTan(in0);
+}
+
+template<typename T, TrigOp Op, size_t B>
+ALPHA4_SIMD_INLINE void trigPacks(
+	const T *in0, const T *in1, T *res0, T *res1, size_t begin, size_t end) {
+	typedef pack_t<T, B>         P;
+	typedef FastMathConstants<T> K;
+	for (size_t i = begin; i < end; i += Lanes<T, B>) {
+		const P x = load<T, B>(in0 + i);
+		P       y = {}, r0, r1 = {};
+		mask_t<T, B> libm;
+		if constexpr (Op == TrigOp::Atan2) {
+			y = load<T, B>(in1 + i);
+			fastAtan2Kernel<P, T>(x, y, r0);
+			const T m = std::numeric_limits<T>::max();
+			libm = !((abs<T, B>(x) <= m) & (abs<T, B>(y) <= m));
+		} else {
+			P s, c;
+			fastSincosKernel<P, T>(x, s, c);
+			if constexpr (Op == TrigOp::Sincos) {
+				r0 = s;
+				r1 = c;
+			} else if constexpr (Op == TrigOp::Sin) {
+				r0 = s;
+			} else if constexpr (Op == TrigOp::Cos) {
+				r0 = c;
+			} else {
+				r0 = s / c;
+			}
+			libm = !(abs<T, B>(x) <= K::reduceMax);
+		}
+		if (any<T, B>(libm)) {
+			for (size_t l = 0; l < Lanes<T, B>; l++) {
+				if (!libm[l]) continue;
+				T a, b;
+				trigScalar<T, Op>(x[l], y[l], a, b);
+				r0[l] = a;
+				r1[l] = b;
+			}
+		}
+		store<T, B>(res0 + i, r0);
+		if constexpr (Op == TrigOp::Sincos) store<T, B>(res1 + i, r1);
+	}
+}
+
+template<typename T, TrigOp Op>
+void trigPacksGeneric(
+	const T *in0, const T *in1, T *res0, T *res1, size_t begin, size_t end) {
+	trigPacks<T, Op, PackBytes<Isa::Generic>>(
+		in0, in1, res0, res1, begin, end);
+}
+
+#ifdef ALPHA4_SIMD_X86
+template<typename T, TrigOp Op>
+ALPHA4_TARGET_AVX2 void trigPacksAVX2(
+	const T *in0, const T *in1, T *res0, T *res1, size_t begin, size_t end) {
+	trigPacks<T, Op, PackBytes<Isa::AVX2>>(
+		in0, in1, res0, res1, begin, end);
+}
+
+template<typename T, TrigOp Op>
+ALPHA4_TARGET_AVX512 void trigPacksAVX512(
+	const T *in0, const T *in1, T *res0, T *res1, size_t begin, size_t end) {
+	trigPacks<T, Op, PackBytes<Isa::AVX512>>(
+		in0, in1, res0, res1, begin, end);
+}
+#endif
+
+template<typename T, TrigOp Op>
+void trigAll(const T *in0, const T *in1, T *res0, T *res1, size_t count) {
+	constexpr size_t W    = MaxLanes<T>;
+	const size_t     full = count - count % W;
+
+	auto packs = ALPHA4_SIMD_SELECT(trigPacks, <T, Op>);
+
+	parallelFor(0, full / W, 2048, [&](size_t b, size_t e) {
+		packs(in0, in1, res0, res1, b * W, e * W);
+	});
+
+	for (size_t i = full; i < count; i++) {
+		T r0, r1;
+		trigScalar<T, Op>(in0[i], in1 ? in1[i] : T(0), r0, r1);
+		res0[i] = r0;
+		if constexpr (Op == TrigOp::Sincos) res1[i] = r1;
+	}
+}
+
+} // namespace
+
+template<typename T> void fastSincos(const T *x, T *s, T *c, size_t count) {
+	trigAll<T, TrigOp::Sincos>(x, nullptr, s, c, count);
+}
+template<typename T> void fastSin(const T *x, T *res, size_t count) {
+	trigAll<T, TrigOp::Sin>(x, nullptr, res, nullptr, count);
+}
+template<typename T> void fastCos(const T *x, T *res, size_t count) {
+	trigAll<T, TrigOp::Cos>(x, nullptr, res, nullptr, count);
+}
+template<typename T> void fastTan(const T *x, T *res, size_t count) {
+	trigAll<T, TrigOp::Tan>(x, nullptr, res, nullptr, count);
+}
+template<typename T>
+void fastAtan2(const T *y, const T *x, T *res, size_t count) {
+	trigAll<T, TrigOp::Atan2>(y, x, res, nullptr, count);
+}
+
+template void fastSincos<float>(const float *, float *, float *, size_t);
+template void fastSincos<double>(const double *, double *, double *, size_t);
+template void fastSin<float>(const float *, float *, size_t);
+template void fastSin<double>(const double *, double *, size_t);
+template void fastCos<float>(const float *, float *, size_t);
+template void fastCos<double>(const double *, double *, size_t);
+template void fastTan<float>(const float *, float *, size_t);
+template void fastTan<double>(const double *, double *, size_t);
+template void fastAtan2<float>(const float *, const float *, float *, size_t);
+template void fastAtan2<double>(
+	const double *, const double *, double *, size_t);
+
+} // namespace alp
@@ -0,0 +1,243 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_FASTMATH_HPP
+#define ALPHA4_COMMON_FASTMATH_HPP
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Trigonometric functions evaluated natively in float or double, using
+// Cody-Waite range reduction and minimax polynomials (after Cephes). The
+// kernels are branch-free so that the batch forms can run them on SIMD packs.
+// Batches match the scalar forms exactly unless the compiler contracts the
+// polynomials into FMA instructions, as on the AVX2 path.
+//
+// Measured error bounds against correctly rounded results:
+//   fastSin, fastCos, fastSincos  float <= 3 ulp for |x| <= 8192,
+//                                 double <= 3 ulp for |x| <= 1e6
+//   fastTan                       float <= 4 ulp, double <= 5 ulp, same ranges
+//   fastAtan2                     float <= 4 ulp, double <= 2 ulp
+// Beyond these ranges, and for infinities or NaNs, all forms fall back to
+// libm. Signed zeros are not preserved.
+
+namespace alp {
+
+template<typename V> struct FastMathTraits {};
+// toInt() gives 0 for values out of the integer range, including NaN.
+template<> struct FastMathTraits<float> {
+	typedef float   scalar;
+	typedef int32_t integer;
+
+	static constexpr const float limit = 2147483648.0f;
+	static void toInt(float v, integer &res) {
+		res = std::fabs(v) < limit ? integer(v) : 0;
+	}
+};
+template<> struct FastMathTraits<double> {
+	typedef double  scalar;
+	typedef int64_t integer;
+
+	static constexpr const double limit = 9223372036854775808.0;
+	static void toInt(double v, integer &res) {
+		res = std::fabs(v) < limit ? integer(v) : 0;
+	}
+};
+
+template<typename T> struct FastMathConstants {};
+template<> struct FastMathConstants<float> {
+	static constexpr const float pi      = 3.14159265358979323846f;
+	static constexpr const float pi_2    = 1.57079632679489661923f;
+	static constexpr const float pi_4    = 0.785398163397448309616f;
+	static constexpr const float pi_2inv = 0.636619772367581343076f;
+	// pi/2 split into parts that multiply exactly with small integers
+	static constexpr const float dp1 = 1.5703125f;
+	static constexpr const float dp2 = 4.837512969970703125e-4f;
+	static constexpr const float dp3 = 7.54953362047672271728515625e-8f;
+	static constexpr const float dp4 = 2.5633440682570896e-12f;
+	// round to integer by adding and subtracting 1.5 * 2^23
+	static constexpr const float rounder = 12582912.0f;
+	// largest argument reduced without libm
+	static constexpr const float reduceMax = 8192.0f;
+	// above this, atan is reduced via pi/4 + atan((a - 1) / (a + 1))
+	static constexpr const float atanSplit = 0.4142135623730950f;
+};
+template<> struct FastMathConstants<double> {
+	static constexpr const double pi      = 3.14159265358979323846;
+	static constexpr const double pi_2    = 1.57079632679489661923;
+	static constexpr const double pi_4    = 0.785398163397448309616;
+	static constexpr const double pi_2inv = 0.636619772367581343076;
+	static constexpr const double dp1     = 1.5707963267341256;
+	static constexpr const double dp2     = 6.077100506303966e-11;
+	static constexpr const double dp3     = 2.0222662487111665e-21;
+	static constexpr const double dp4     = 8.4784276603689e-32;
+	static constexpr const double rounder   = 6755399441055744.0;
+	static constexpr const double reduceMax = 1e6;
+	// threshold of the atan reduction, as for float
+	static constexpr const double atanSplit = 0.66;
+	// low part of pi/4 lost in the reduction
+	static constexpr const double pi_4lo = 3.061616997868383e-17;
+};
+
+// Generic kernels, instantiated for scalars and for SIMD packs.
+template<typename V, typename T = typename FastMathTraits<V>::scalar>
+__attribute__((always_inline)) inline void
+	fastSincosKernel(const V &x, V &s, V &c) {
+	typedef FastMathConstants<T> K;
+
+	const V j = (x * K::pi_2inv + K::rounder) - K::rounder;
+	typename FastMathTraits<V>::integer q;
+	FastMathTraits<V>::toInt(j, q);
+
+	const V r = (((x - j * K::dp1) - j * K::dp2) - j * K::dp3) - j * K::dp4;
+	const V z = r * r;
+
+	V ps, pc;
+	if constexpr (std::is_same_v<T, float>) {
+		ps = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f);
+		pc = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z
+					+ 4.166664568298827e-2f);
+	} else {
+		ps = (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z
+						 + 2.75573136213857245213e-6)
+						* z
+					- 1.98412698295895385996e-4)
+					 * z
+				 + 8.33333333332211858878e-3)
+					* z
+				- 1.66666666666666307295e-1);
+		pc = (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z
+						 - 2.75573141792967388112e-7)
+						* z
+					+ 2.48015872888517045348e-5)
+					 * z
+				 - 1.38888888888730564116e-3)
+					* z
+				+ 4.16666666666665929218e-2);
+	}
+	const V sr = r + r * z * ps;
+	const V cr = (T(1) - T(0.5) * z) + z * z * pc;
+
+	const auto swap = (q & 1) != 0;
+	const V    ss   = swap ? cr : sr;
+	const V    cc   = swap ? sr : cr;
+	s               = ((q & 2) != 0) ? -ss : ss;
+	c               = (((q + 1) & 2) != 0) ? -cc : cc;
+}
+
+template<typename V, typename T = typename FastMathTraits<V>::scalar>
+__attribute__((always_inline)) inline void
+	fastAtan2Kernel(const V &y, const V &x, V &res) {
+	typedef FastMathConstants<T> K;
+
+	const V ax = x < 0 ? -x : x;
+	const V ay = y < 0 ? -y : y;
+	const V mx = ax > ay ? ax : ay;
+	const V mn = ax > ay ? ay : ax;
+	const V a  = mx > 0 ? mn / (mx > 0 ? mx : V{} + T(1)) : V{};
+
+	const auto big = a > K::atanSplit;
+	const V    t   = big ? (a - T(1)) / (a + T(1)) : a;
+	const V    z   = t * t;
+
+	V r;
+	if constexpr (std::is_same_v<T, float>) {
+		const V p = ((8.05374449538e-2f * z - 1.38776856032e-1f) * z
+								 + 1.99777106478e-1f)
+								* z
+			- 3.33329491539e-1f;
+		r = (t * z * p + t) + (big ? V{} + K::pi_4 : V{});
+	} else {
+		const V p = (((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1)
+										* z
+									- 7.500855792314704667340e1)
+									 * z
+								 - 1.228866684490136173410e2)
+					* z
+				- 6.485021904942025371773e1;
+		const V q = ((((z + 2.485846490142306297962e1) * z
+									 + 1.650270098316988542046e2)
+									* z
+								+ 4.328810604912902668951e2)
+								 * z
+							 + 4.853903996359136964868e2)
+					* z
+				+ 1.945506571482613964425e2;
+		r = (t * (z * p / q) + (big ? V{} + K::pi_4lo : V{}) + t)
+			+ (big ? V{} + K::pi_4 : V{});
+	}
+
+	r = ay > ax ? K::pi_2 - r : r;
+	r   = x < 0 ? K::pi - r : r;
+	res = y < 0 ? -r : r;
+}
+
+template<typename T> inline void fastSincos(T x, T &s, T &c) {
+	if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+		if (std::fabs(x) <= FastMathConstants<T>::reduceMax) {
+			fastSincosKernel<T>(x, s, c);
+			return;
+		}
+	}
+	s = T(std::sin(x));
+	c = T(std::cos(x));
+}
+
+template<typename T> inline T fastSin(T x) {
+	T s, c;
+	fastSincos(x, s, c);
+	return s;
+}
+template<typename T> inline T fastCos(T x) {
+	T s, c;
+	fastSincos(x, s, c);
+	return c;
+}
+template<typename T> inline T fastTan(T x) {
+	if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+		if (std::fabs(x) <= FastMathConstants<T>::reduceMax) {
+			T s, c;
+			fastSincosKernel<T>(x, s, c);
+			return s / c;
+		}
+	}
+	return T(std::tan(x));
+}
+
+template<typename T> inline T fastAtan2(T y, T x) {
+	if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+		if (std::isfinite(y) && std::isfinite(x)) {
+			T res;
+			fastAtan2Kernel<T>(y, x, res);
+			return res;
+		}
+	}
+	return T(std::atan2(y, x));
+}
+
+// Batch forms over arrays, vectorized for the instruction set selected at
+// runtime. Output arrays may alias the inputs.
+template<typename T> void fastSincos(const T *x, T *s, T *c, size_t count);
+template<typename T> void fastSin(const T *x, T *res, size_t count);
+template<typename T> void fastCos(const T *x, T *res, size_t count);
+template<typename T> void fastTan(const T *x, T *res, size_t count);
+template<typename T>
+void fastAtan2(const T *y, const T *x, T *res, size_t count);
+
+} // namespace alp
+#endif
@@ -0,0 +1,291 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "lineindex.hpp"
+
+#include "alpha4/common/mappedfile.hpp"
+#include "alpha4/common/parallelscanner.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace alp {
+
+namespace {
+
+using namespace simd;
+
+// bytes per task of build()
+constexpr const size_t BlockSize = size_t(1) << 20;
+
+// Lines end at '\n', '\r' or "\r\n", as records do, see countLineEnds(). The
+// last byte of a line break ends the line, next is the byte after c.
+const auto IsLineEnd = [](const auto &c, const auto &next) ALPHA4_SIMD_LAMBDA {
+	return maskOr(c == '\n', maskAnd(c == '\r', next != '\n'));
+};
+
+// Line ends in [p, end) of a buffer ending at last.
+uint64_t countBlockLineEnds(const char *p, const char *end, const char *last) {
+	const uint64_t res = countLineEnds(p, end);
+	// a "\r\n" split by the block end is counted with the '\n'
+	return res - (end < last && end[-1] == '\r' && *end == '\n');
+}
+
+// Start of the line after the one at p, nullptr if it is the last.
+const char *nextLine(const char *p, const char *end) {
+	for (; p < end; p++)
+		if (*p == '\n' || *p == '\r') {
+			p += *p == '\r' && p + 1 < end && p[1] == '\n';
+			return p + 1;
+		}
+	return nullptr;
+}
+
+// Stores the start offsets of lines that are a multiple of stride, for lines
+// starting in [begin, end), given the number of line ends before begin.
+struct Sampling {
+	const char *data;
+	uint64_t *  samples;
+	uint64_t    count;
+	uint64_t    size;
+	uint32_t    stride;
+};
+
+template<size_t W>
+ALPHA4_SIMD_INLINE void sampleLines(
+	const Sampling &s, size_t begin, size_t end, uint64_t newlines) {
+	const char *p = s.data + begin, *e = s.data + end, *last = s.data + s.size;
+	// the line end preceding the next sampled line
+	uint64_t next = (newlines / s.stride + 1) * s.stride - 1;
+
+	auto sample = [&](const char *q) {
+		const uint64_t slot = (newlines + 1) / s.stride;
+		if (slot < s.count) s.samples[slot] = uint64_t(q + 1 - s.data);
+		next += s.stride;
+	};
+
+	// the byte after every lane is loaded as well
+	constexpr size_t Step = 64;
+	for (; size_t(e - p) >= Step && size_t(last - p) > Step; p += Step) {
+		uint64_t bits = 0;
+		for (size_t i = 0; i < Step; i += W)
+			bits |= bitmask<W>(IsLineEnd(
+								loadBytes<W>(p + i), loadBytes<W>(p + i + 1)))
+				<< i;
+		const uint64_t n = uint64_t(__builtin_popcountll(bits));
+		if (next >= newlines + n) {
+			newlines += n;
+			continue;
+		}
+		for (; bits; bits &= bits - 1, newlines++)
+			if (newlines == next) sample(p + __builtin_ctzll(bits));
+	}
+	for (; p < e; p++)
+		if (IsLineEnd(*p, p + 1 < last ? p[1] : 0)) {
+			if (newlines == next) sample(p);
+			newlines++;
+		}
+}
+
+void sampleLinesGeneric(
+	const Sampling &s, size_t begin, size_t end, uint64_t newlines) {
+	sampleLines<ByteLanes<Isa::Generic>>(s, begin, end, newlines);
+}
+
+#ifdef ALPHA4_SIMD_X86
+ALPHA4_TARGET_AVX2 void sampleLinesAVX2(
+	const Sampling &s, size_t begin, size_t end, uint64_t newlines) {
+	sampleLines<ByteLanes<Isa::AVX2>>(s, begin, end, newlines);
+}
+
+ALPHA4_TARGET_AVX512 void sampleLinesAVX512(
+	const Sampling &s, size_t begin, size_t end, uint64_t newlines) {
+	sampleLines<ByteLanes<Isa::AVX512>>(s, begin, end, newlines);
+}
+#endif
+
+struct FileHeader {
+	char     magic[8];
+	// 0x01020304 in the byte order of the writer
+	uint32_t order;
+	uint32_t stride;
+	uint64_t size;
+	uint64_t lines;
+	uint64_t stamp;
+	uint64_t count;
+};
+
+constexpr const char     Magic[8] = {'A', '4', 'L', 'I', 'D', 'X', 0, 2};
+constexpr const uint32_t Order    = 0x01020304;
+
+} // namespace
+
+void LineIndex::build(
+	const char *data, size_t size, uint32_t stride, ThreadPool *pool) {
+	clear();
+	_stride = std::max<uint32_t>(stride, 1);
+	_size   = size;
+	if (size == 0) return;
+
+	ThreadPool & tp     = pool ? *pool : ThreadPool::Global();
+	const size_t blocks = (size + BlockSize - 1) / BlockSize;
+
+	// line ends before each block
+	std::vector<uint64_t> before(blocks + 1, 0);
+	tp.parallelFor(0, blocks, 1, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			before[i + 1] = countBlockLineEnds(
+				data + i * BlockSize,
+				data + std::min(size, (i + 1) * BlockSize),
+				data + size);
+	});
+	for (size_t i = 0; i < blocks; i++)
+		before[i + 1] += before[i];
+
+	_lines = before[blocks] + (data[size - 1] != '\n' && data[size - 1] != '\r');
+	_samples.resize((_lines + _stride - 1) / _stride);
+	_samples[0] = 0;
+
+	const Sampling s{data, _samples.data(), _samples.size(), size, _stride};
+	auto           sample = ALPHA4_SIMD_SELECT(sampleLines);
+	tp.parallelFor(0, blocks, 1, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			sample(
+				s, i * BlockSize, std::min(size, (i + 1) * BlockSize), before[i]);
+	});
+}
+
+void LineIndex::clear() {
+	_samples.clear();
+	_size  = 0;
+	_lines = 0;
+}
+
+size_t LineIndex::lineOffset(const char *data, size_t n) const {
+	if (n >= _lines) return size_t(_size);
+	const char *p = data + _samples[n / _stride], *end = data + _size;
+	for (size_t i = n % _stride; i > 0; i--) {
+		// only if the index does not match the buffer after all
+		p = nextLine(p, end);
+		if (!p) return size_t(_size);
+	}
+	return size_t(p - data);
+}
+
+size_t LineIndex::lineAt(const char *data, size_t offset) const {
+	if (offset >= _size) return size_t(_lines);
+	const size_t slot =
+		size_t(std::upper_bound(_samples.begin(), _samples.end(), offset)
+					 - _samples.begin())
+		- 1;
+	return slot * _stride
+		+ size_t(countBlockLineEnds(
+			data + _samples[slot], data + offset, data + _size));
+}
+
+uint64_t LineIndex::FileStamp(const char *path) {
+	std::error_code ec;
+	const auto      size = std::filesystem::file_size(path, ec);
+	if (ec) return 0;
+	const auto time = std::filesystem::last_write_time(path, ec);
+	if (ec) return 0;
+	const uint64_t stamp = uint64_t(time.time_since_epoch().count())
+		^ (uint64_t(size) * 0x9e3779b97f4a7c15ULL);
+	return stamp ? stamp : 1;
+}
+
+bool LineIndex::save(const char *path, uint64_t stamp) const {
+	FileHeader header;
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.order  = Order;
+	header.stride = _stride;
+	header.size   = _size;
+	header.lines  = _lines;
+	header.stamp  = stamp;
+	header.count  = _samples.size();
+
+	const std::string temp = std::string(path) + ".tmp";
+	std::FILE *       f    = std::fopen(temp.c_str(), "wb");
+	if (!f) return false;
+	bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1
+		&& std::fwrite(_samples.data(), sizeof(uint64_t), _samples.size(), f)
+			== _samples.size();
+	ok = (std::fclose(f) == 0) && ok;
+	ok = ok && std::rename(temp.c_str(), path) == 0;
+	if (!ok) {
+		const int err = errno;
+		std::remove(temp.c_str());
+		errno = err;
+	}
+	return ok;
+}
+
+bool LineIndex::load(const char *path, size_t size, uint64_t stamp) {
+	clear();
+	MappedFile file;
+	if (!file.open(path)) return false;
+
+	FileHeader header;
+	if (file.size() < sizeof(header)) return false;
+	std::memcpy(&header, file.data(), sizeof(header));
+	const size_t payload = file.size() - sizeof(header);
+	if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0
+			|| header.order != Order || header.stride == 0 || header.size != size
+			|| header.stamp != stamp || header.lines > header.size
+			|| header.count != (header.lines + header.stride - 1) / header.stride
+			|| payload % sizeof(uint64_t) != 0
+			|| payload / sizeof(uint64_t) != header.count)
+		return false;
+
+	_samples.resize(header.count);
+	std::memcpy(_samples.data(), file.data() + sizeof(header), payload);
+	// lookups rely on samples starting at 0 and increasing within the buffer
+	for (size_t i = 0; i < _samples.size(); i++)
+		if (i == 0 ? _samples[i] != 0
+							 : _samples[i] <= _samples[i - 1] || _samples[i] >= header.size) {
+			_samples.clear();
+			return false;
+		}
+	_stride = header.stride;
+	_size   = header.size;
+	_lines  = header.lines;
+	return true;
+}
+
+bool LineIndex::open(
+	const char *path,
+	const char *data,
+	size_t      size,
+	uint32_t    stride,
+	ThreadPool *pool) {
+	const uint64_t    stamp = FileStamp(path);
+	const std::string index = IndexPath(path);
+	if (stamp && load(index.c_str(), size, stamp) && _stride == stride)
+		return true;
+
+	build(data, size, stride, pool);
+	// e.g. a read-only directory, the index then only lives in memory
+	if (stamp) save(index.c_str(), stamp);
+	return false;
+}
+
+} // namespace alp
@@ -0,0 +1,105 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_LINEINDEX_HPP
+#define ALPHA4_COMMON_LINEINDEX_HPP
+#include "alpha4/common/threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alp {
+
+// Start offsets of every stride-th line of a buffer, for random access by
+// line number. Lines end at '\n', '\r' or "\r\n", as RecordError lines are
+// counted, see countLineEnds(). The table is built with a parallel SIMD
+// newline scan and takes 8 bytes per stride lines. lineOffset() starts at the
+// nearest sample and skips at most stride - 1 lines, lineAt() is a binary
+// search followed by such a scan.
+//
+// Indexes can be stored next to the file they describe and are validated by
+// its size and modification time when loaded again.
+class LineIndex {
+protected:
+	std::vector<uint64_t> _samples;
+	uint64_t              _size   = 0;
+	uint64_t              _lines  = 0;
+	uint32_t              _stride = DefaultStride;
+
+public:
+	static constexpr const uint32_t DefaultStride = 64;
+
+	LineIndex() {}
+	LineIndex(
+		const char *data,
+		size_t      size,
+		uint32_t    stride = DefaultStride,
+		ThreadPool *pool   = nullptr) {
+		build(data, size, stride, pool);
+	}
+
+	void build(
+		const char *data,
+		size_t      size,
+		uint32_t    stride = DefaultStride,
+		ThreadPool *pool   = nullptr);
+	void clear();
+
+	// Number of lines, including a last one without a newline.
+	size_t   lines() const { return size_t(_lines); }
+	// Size of the indexed buffer.
+	size_t   size() const { return size_t(_size); }
+	uint32_t stride() const { return _stride; }
+
+	// Offset of the start of line n, counting from 0, or size() if there is no
+	// such line. data must be the indexed buffer.
+	size_t lineOffset(const char *data, size_t n) const;
+	// Number of the line containing offset, or lines() past the end.
+	size_t lineAt(const char *data, size_t offset) const;
+
+	// Identifies the contents of a file by size and modification time, 0 if
+	// it cannot be determined.
+	static uint64_t FileStamp(const char *path);
+	// Where the index of the file at path is stored.
+	static std::string IndexPath(const char *path) {
+		return std::string(path) + ".lidx";
+	}
+
+	// Stores the index, replacing the file atomically. Returns false with
+	// errno set on failure.
+	bool save(const char *path, uint64_t stamp) const;
+	// Loads an index stored for a buffer of size bytes with the given stamp.
+	// Returns false, leaving the index empty, if it cannot be read or is
+	// stale.
+	bool load(const char *path, size_t size, uint64_t stamp);
+
+	// Uses the index stored next to the file at path if it is up to date,
+	// otherwise builds one over its contents, [data, data + size), and tries
+	// to store it. Returns true if the stored index was used.
+	bool open(
+		const char *path,
+		const char *data,
+		size_t      size,
+		uint32_t    stride = DefaultStride,
+		ThreadPool *pool   = nullptr);
+};
+
+} // namespace alp
+#endif
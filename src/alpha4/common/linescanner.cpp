@@ -17,10 +17,161 @@ Alpha4. If not, see <https://www.gnu.org/licenses/>.
 
 #include "linescanner.hpp"
 
+#include "alpha4/common/lineindex.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <algorithm>
 #include <cstring>
 
 namespace alp {
 
+namespace {
+
+using namespace simd;
+
+// Byte classes, usable on single characters as well as byte vectors.
+const auto IsToken   = [](const auto &c) { return c > ' '; };
+const auto IsSpace   = [](const auto &c) { return c <= ' '; };
+const auto IsNewLine = [](const auto &c) ALPHA4_SIMD_LAMBDA {
+	return maskOr(c == '\n', c == '\r');
+};
+const auto IsLineEnd = [](const auto &c) ALPHA4_SIMD_LAMBDA {
+	return maskOr(c > ' ', c == '\n', c == '\r');
+};
+
+inline const char *lineStart(const char *p, const char *begin) {
+	while ((p > begin) && (p[-1] != '\n') && (p[-1] != '\r'))
+		p--;
+	return p;
+}
+
+// Newline runs are short, a vector pass does not pay off.
+inline const char *skipNewLines(const char *p, const char *end) {
+	while ((p < end) && ((*p == '\n') || (*p == '\r')))
+		p++;
+	return p;
+}
+
+// Finds the closing quote, skipping escaped characters if doesc is set. The
+// scan stops at every backslash anyway, so escaped tells for free whether the
+// string needs unescaping.
+template<size_t W>
+ALPHA4_SIMD_INLINE const char *findQuote(
+	const char *p, const char *end, char quote, bool doesc, bool &escaped) {
+	if (!doesc)
+		return findByte<W>(p, end, [quote](const auto &c) { return c == quote; });
+	const auto cls = [quote](const auto &c) ALPHA4_SIMD_LAMBDA {
+		return maskOr(c == quote, c == '\\');
+	};
+	while ((p = findByte<W>(p, end, cls)) < end && *p != quote) {
+		escaped = true;
+		p       = std::min(p + 2, end);
+	}
+	return p;
+}
+
+template<size_t W>
+ALPHA4_SIMD_INLINE bool anyString(
+	const char *&p, const char *end, int &newLine, bool doesc, bool &escaped,
+	std::string_view &res) {
+	newLine           = 0;
+	escaped           = false;
+	const char *token = findByte<W>(p, end, IsToken);
+	if (token >= end) {
+		// the byte loop this replaces reset res on every skipped blank
+		if (token != p) res = {};
+		p = end;
+		return false;
+	}
+
+	if ((*token == '"') || (*token == '\'')) {
+		const char *q = findQuote<W>(token + 1, end, *token, doesc, escaped);
+		res           = {token + 1, size_t(q - token - 1)};
+		p             = (q < end) ? q + 1 : end;
+		return true;
+	}
+
+	const char *q = findByte<W>(token + 1, end, IsSpace);
+	res           = {token, size_t(q - token)};
+	if (q >= end)
+		p = end;
+	else if ((*q == '\n') || (*q == '\r')) {
+		newLine = 1;
+		p       = skipNewLines(q, end);
+	} else
+		p = q + 1;
+	return true;
+}
+
+template<size_t W>
+ALPHA4_SIMD_INLINE const char *findNewLine(const char *p, const char *end) {
+	return findByte<W>(p, end, IsNewLine);
+}
+
+template<size_t W>
+ALPHA4_SIMD_INLINE const char *findLineEnd(const char *p, const char *end) {
+	return findByte<W>(p, end, IsLineEnd);
+}
+
+template<size_t W>
+ALPHA4_SIMD_INLINE const char *findToken(const char *p, const char *end) {
+	return findByte<W>(p, end, IsToken);
+}
+
+bool anyStringGeneric(
+	const char *&p, const char *end, int &newLine, bool doesc, bool &escaped,
+	std::string_view &res) {
+	return anyString<ByteLanes<Isa::Generic>>(
+		p, end, newLine, doesc, escaped, res);
+}
+const char *findNewLineGeneric(const char *p, const char *end) {
+	return findNewLine<ByteLanes<Isa::Generic>>(p, end);
+}
+const char *findLineEndGeneric(const char *p, const char *end) {
+	return findLineEnd<ByteLanes<Isa::Generic>>(p, end);
+}
+const char *findTokenGeneric(const char *p, const char *end) {
+	return findToken<ByteLanes<Isa::Generic>>(p, end);
+}
+
+#ifdef ALPHA4_SIMD_X86
+ALPHA4_TARGET_AVX2 bool anyStringAVX2(
+	const char *&p, const char *end, int &newLine, bool doesc, bool &escaped,
+	std::string_view &res) {
+	return anyString<ByteLanes<Isa::AVX2>>(p, end, newLine, doesc, escaped, res);
+}
+ALPHA4_TARGET_AVX2 const char *findNewLineAVX2(const char *p, const char *end) {
+	return findNewLine<ByteLanes<Isa::AVX2>>(p, end);
+}
+ALPHA4_TARGET_AVX2 const char *findLineEndAVX2(const char *p, const char *end) {
+	return findLineEnd<ByteLanes<Isa::AVX2>>(p, end);
+}
+ALPHA4_TARGET_AVX2 const char *findTokenAVX2(const char *p, const char *end) {
+	return findToken<ByteLanes<Isa::AVX2>>(p, end);
+}
+
+ALPHA4_TARGET_AVX512 bool anyStringAVX512(
+	const char *&p, const char *end, int &newLine, bool doesc, bool &escaped,
+	std::string_view &res) {
+	return anyString<ByteLanes<Isa::AVX512>>(
+		p, end, newLine, doesc, escaped, res);
+}
+ALPHA4_TARGET_AVX512 const char *
+	findNewLineAVX512(const char *p, const char *end) {
+	return findNewLine<ByteLanes<Isa::AVX512>>(p, end);
+}
+ALPHA4_TARGET_AVX512 const char *
+	findLineEndAVX512(const char *p, const char *end) {
+	return findLineEnd<ByteLanes<Isa::AVX512>>(p, end);
+}
+ALPHA4_TARGET_AVX512 const char *
+	findTokenAVX512(const char *p, const char *end) {
+	return findToken<ByteLanes<Isa::AVX512>>(p, end);
+}
+#endif
+
+} // namespace
+
 LineScanner::LineScanner() : _data(0), _p(0), _end(0), _newLine(1) {}
 
 LineScanner::LineScanner(const char *data) : LineScanner() { assign(data); }
@@ -33,6 +184,7 @@ LineScanner::LineScanner(const char *data, const char *e) : LineScanner() {
 LineScanner::~LineScanner() {}
 
 void LineScanner::assign(const char *data) {
+	_file.reset();
 	if (nullptr == data) {
 		_p = _data = nullptr;
 		_end       = nullptr;
@@ -43,122 +195,160 @@ void LineScanner::assign(const char *data) {
 		_end     = _data + strlen(data);
 		_newLine = 1;
 	}
+	_offset = 0;
 }
 void LineScanner::assign(const char *data, size_t cb) {
+	_file.reset();
 	_data    = data;
 	_p       = data;
 	_end     = _data + cb;
 	_newLine = 1;
+	_offset  = 0;
 }
 void LineScanner::assign(const char *data, const char *e) {
+	_file.reset();
 	_data    = data;
 	_p       = data;
 	_end     = e;
 	_newLine = 1;
+	_offset  = 0;
+}
+
+bool LineScanner::open(const char *path) {
+	MappedFile file;
+	if (!file.open(path)) return false;
+	assign(file.data(), file.size());
+	_file = std::make_shared<const MappedFile>(std::move(file));
+	return true;
+}
+bool LineScanner::open(int fd) {
+	MappedFile file;
+	if (!file.open(fd)) return false;
+	assign(file.data(), file.size());
+	_file = std::make_shared<const MappedFile>(std::move(file));
+	return true;
 }
+void LineScanner::close() { assign(nullptr); }
 
-size_t LineScanner::tell() const { return (size_t)_p - (size_t)_data; }
+size_t LineScanner::tell() const { return _offset + (size_t)(_p - _data); }
 
-size_t LineScanner::seek(int offset, int origin) {
+size_t LineScanner::seek(int64_t offset, int origin) {
 	std::ptrdiff_t p;
 	switch (origin) {
 		default:
-		case 0: p = offset; break;
-		case 1: p = (std::ptrdiff_t)_p - (std::ptrdiff_t)_data + offset; break;
-		case 2: p = (std::ptrdiff_t)_end - (std::ptrdiff_t)_data + offset; break;
+		case 0: p = offset - (int64_t)_offset; break;
+		case 1: p = (_p - _data) + offset; break;
+		case 2: p = (_end - _data) + offset; break;
 	}
 	if (p < 0)
 		p = 0;
-	else if (p > (std::ptrdiff_t)_end - (std::ptrdiff_t)_data)
-		p = (std::ptrdiff_t)_end - (std::ptrdiff_t)_data;
+	else if (p > _end - _data)
+		p = _end - _data;
 
 	_p = _data + p;
 
-	return (size_t)p;
+	return _offset + (size_t)p;
 }
 
-bool LineScanner::seekNewLine(bool alwaysAdvance) {
-	if (_newLine && (!alwaysAdvance)) return true;
+bool LineScanner::seekLine(const LineIndex &index, size_t n) {
+	if (_offset != 0 || index.size() != size() || n >= index.lines())
+		return false;
+	_p       = _data + index.lineOffset(_data, n);
 	_newLine = 1;
+	return true;
+}
 
-	while ((_p < _end) && (*_p != '\n') && (*_p != '\r'))
-		_p++;
-	if (_p >= _end) return false;
+size_t LineScanner::tellLine(const LineIndex &index) const {
+	if (_offset != 0 || index.size() != size()) return index.lines();
+	return index.lineAt(_data, size_t(_p - _data));
+}
 
-	while ((_p < _end) && ((*_p == '\n') || (*_p == '\r')))
-		_p++;
-	if (_p >= _end) return false;
+bool LineScanner::eof() {
+	while (_p >= _end)
+		if (!underflow(_p)) return true;
+	return false;
+}
 
+template<typename Op> bool LineScanner::retry(const Op &op) {
+	for (;;) {
+		const char *start   = _p;
+		const int   newLine = _newLine;
+		const bool  res     = op();
+		if (_p < _end || !underflow(start)) return res;
+		_p       = start;
+		_newLine = newLine;
+	}
+}
+
+bool LineScanner::skipNewLineRun() {
+	do
+		_p = skipNewLines(_p, _end);
+	while (_p >= _end && underflow(_p));
+	return _p < _end;
+}
+
+bool LineScanner::getToken(std::string_view &res) {
+	for (;;) {
+		const char *start = _p;
+		ALPHA4_SIMD_SELECT(anyString)(
+			_p, _end, _newLine, flags & FUSE_ESCAPE, _escaped, res);
+		if (_p < _end) return true;
+		// the token is complete, only the newlines after it reach the end
+		if (_newLine) break;
+		if (!underflow(start)) return true;
+		_p = start;
+	}
+	if (!_stableViews) {
+		// refills may move the buffer while the newline run continues
+		_token.assign(res);
+		res = _token;
+	}
+	skipNewLineRun();
 	return true;
 }
 
-bool LineScanner::getAnyString(std::string_view &res) {
-	int  longstring = 0, esc = 0, doesc = flags & FUSE_ESCAPE;
-	char quote;
-	_newLine = 0;
+bool LineScanner::seekNewLine(bool alwaysAdvance) {
+	if (_newLine && (!alwaysAdvance)) return true;
+	_newLine = 1;
+	do
+		_p = ALPHA4_SIMD_SELECT(findNewLine)(_p, _end);
+	while (_p >= _end && underflow(_p));
+	if (_p >= _end) return false;
 
-	size_t      res_len = 0;
-	const char *res_ptr = nullptr;
-
-	while (_p < _end) {
-		if (longstring) {
-			if (esc)
-				esc = 0;
-			else if (doesc && (*_p == '\\')) {
-				esc = true;
-			} else if (*_p == quote) {
-				res_len = (size_t)_p - (size_t)res_ptr;
-				_p++;
-				res = {res_ptr, res_len};
-				return true;
-			}
-			_p++;
-		} else if (*_p > ' ') {
-			if (!res_ptr) {
-				res_ptr = _p;
-				if ((*_p == '"') || (*_p == '\'')) {
-					longstring = 1;
-					quote      = *_p;
-					res_ptr++;
-				}
-			}
-			_p++;
-		} else {
-			if (res_ptr) res_len = (size_t)_p - (size_t)res_ptr;
-
-			if ((_p < _end) && ((*_p == '\n') || (*_p == '\r'))) {
-				if (res_ptr) _newLine = 1;
-				while ((_p < _end) && ((*_p == '\n') || (*_p == '\r')))
-					_p++;
-			} else {
-				_p++;
-			}
+	return skipNewLineRun();
+}
 
-			res = {res_ptr, res_len};
-			if (res_ptr) return true;
-		}
-	}
-	if (res_ptr) {
-		res_len = (size_t)_end - (size_t)res_ptr;
-		res     = {res_ptr, res_len};
-		return true;
+bool LineScanner::getAnyString(std::string_view &res) {
+	bool skipped = false;
+	for (;;) {
+		const char *token = ALPHA4_SIMD_SELECT(findToken)(_p, _end);
+		skipped           = skipped || token != _p;
+		_p                = token;
+		if (_p < _end) return getToken(res);
+		if (!underflow(_p)) break;
 	}
+	_newLine = 0;
+	_escaped = false;
+	// as anyString() at the end of the input
+	if (skipped) res = {};
 	return false;
 }
 
 bool LineScanner::getLnString(std::string_view &res) {
 	if (_newLine) return false;
-	while ((_p < _end) && (*_p <= ' ')) {
-		if ((*_p == '\n') || (*_p == '\r')) {
-			while ((_p < _end) && ((*_p == '\n') || (*_p == '\r')))
-				_p++;
-			_newLine = 1;
-			return false;
-		}
-		_p++;
+	do
+		_p = ALPHA4_SIMD_SELECT(findLineEnd)(_p, _end);
+	while (_p >= _end && underflow(_p));
+	if (_p >= _end) {
+		_escaped = false;
+		return false;
 	}
-
-	return getString(res);
+	if ((*_p == '\n') || (*_p == '\r')) {
+		_newLine = 1;
+		skipNewLineRun();
+		return false;
+	}
+	return getToken(res);
 }
 
 bool LineScanner::getLnFirstString(std::string_view &res) {
@@ -168,16 +358,15 @@ bool LineScanner::getLnFirstString(std::string_view &res) {
 }
 
 bool LineScanner::getLnRemainder(std::string_view &res) {
-	if (_p >= _end) { return false; }
-	size_t      res_len = 0;
-	const char *res_ptr = _p;
+	if (eof()) { return false; }
+	return retry([this, &res] {
+		const char *res_ptr = _p;
+		_escaped            = false;
 
-	while ((_p < _end) && (*_p != '\r') && (*_p != '\n')) {
-		_p++;
-	}
-	res_len = (size_t)_p - (size_t)res_ptr;
-	res     = {res_ptr, res_len};
-	return true;
+		_p  = ALPHA4_SIMD_SELECT(findNewLine)(_p, _end);
+		res = {res_ptr, (size_t)(_p - res_ptr)};
+		return true;
+	});
 }
 
 bool LineScanner::getTrimmedLine(std::string_view &res, bool rewind) {
@@ -190,7 +379,12 @@ bool LineScanner::getTrimmedLine(std::string_view &res, bool rewind) {
 	} else {
 		for (p0 = _p; (p0 < _end) && (*p0 <= ' '); p0++)
 			;
-		if (p0 >= _end) return false;
+		if (p0 >= _end) {
+			// the line is scanned back to its start, which must stay buffered
+			// along with the position
+			const char *line = std::min(lineStart(p0, _data), _p);
+			return underflow(line) && getTrimmedLine(res, rewind);
+		}
 	}
 
 	f = l = p0;
@@ -198,13 +392,19 @@ bool LineScanner::getTrimmedLine(std::string_view &res, bool rewind) {
 		if (*p > ' ') f = p;
 	for (p = p0; (p < _end) && (*p != '\n') && (*p != '\r'); p++)
 		if (*p > ' ') l = p;
+	// the line continues in input not read yet
+	if (p >= _end) {
+		const char *line = std::min(lineStart(p0, _data), _p);
+		if (underflow(line)) return getTrimmedLine(res, rewind);
+	}
 
-	res = {f, (size_t)(l - f + 1)};
+	res      = {f, (size_t)(l - f + 1)};
+	_escaped = false;
 
 	return true;
 }
 
-void MultilineScanner::processLine(const std::string &line) {
+void MultilineScanner::processLine(std::string_view line) {
 	char quote  = 0;
 	bool escape = false;
 	bool empty  = true;
@@ -241,16 +441,24 @@ void MultilineScanner::processLine(const std::string &line) {
 	}
 
 	if (_compound.empty() && !isContinuation)
-		callback(line.substr(0, end));
+		emit(line.substr(0, end));
 	else {
-		_compound += delimiter + line.substr(0, end);
+		_compound += delimiter;
+		_compound += line.substr(0, end);
 		if (!isContinuation) flush();
 	}
 }
 
+void MultilineScanner::emit(std::string_view line) {
+	if (viewCallback)
+		viewCallback(line);
+	else if (callback)
+		callback(std::string(line));
+}
+
 void MultilineScanner::flush() {
 	if (_compound.empty()) return;
-	callback(_compound);
+	emit(_compound);
 	_compound.clear();
 }
 
@@ -17,18 +17,28 @@ Alpha4. If not, see <https://www.gnu.org/licenses/>.
 
 #ifndef ALPHA4_COMMON_LINESCANNER_HPP
 #define ALPHA4_COMMON_LINESCANNER_HPP
+#include "alpha4/common/arena.hpp"
 #include "alpha4/common/error.hpp"
+#include "alpha4/common/escape.hpp"
+#include "alpha4/common/mappedfile.hpp"
 #include "alpha4/common/string.hpp"
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 namespace alp {
 
+class LineIndex;
+
 class LineScanner {
 public:
 	enum ReadMode { AnyString, InLineString, FirstString, Remainder };
@@ -44,29 +54,79 @@ protected:
 	const char *_data;
 	const char *_p, *_end;
 	int         _newLine;
+	// shared by copies, which scan the same mapping
+	std::shared_ptr<const MappedFile> _file;
+	// stream position of _data, see StreamScanner
+	size_t _offset = 0;
+	// views stay valid while the buffer is, false if it moves on refills
+	bool _stableViews = true;
+	// the last string returned contains backslash escapes
+	bool _escaped = false;
+	// copy of a token whose buffer was refilled before the operation ended
+	std::string _token;
+
+	// Called when an operation ran into the end of the buffer. Streaming
+	// scanners append more input, keeping at least [start, _end) and rebasing
+	// start and _p if the buffer moves. Returns true if the buffer changed, so
+	// the operation must continue from start. Skipping blanks and newlines
+	// passes the scan position, so that only unfinished tokens are kept.
+	virtual bool underflow(const char *&start) {
+		(void)start;
+		return false;
+	}
+	template<typename Op> bool retry(const Op &op);
+	// Skips newlines across refills, false at the end of input.
+	bool skipNewLineRun();
+	// Scans the token at _p, which is not a blank.
+	bool getToken(std::string_view &res);
 
 public:
 	LineScanner();
 	LineScanner(const char *data);
 	LineScanner(const char *data, size_t cb);
 	LineScanner(const char *data, const char *e);
-	~LineScanner();
+	virtual ~LineScanner();
+
+	// Copies continue from the same position, e.g. to save a cursor.
+	LineScanner(const LineScanner &) = default;
+	LineScanner(LineScanner &&)      = default;
+	LineScanner &operator=(const LineScanner &) = default;
+	LineScanner &operator=(LineScanner &&) = default;
 
 	uint32_t flags = 0;
 
+	// Backs the DecodeBuffer of getAll() and call(), e.g. an Arena. Decoded
+	// const char * values then stay valid until the resource is reset.
+	std::pmr::memory_resource *memory = nullptr;
+
+	// Assigning a caller owned buffer closes a file opened before.
 	void assign(const char *data);
 	void assign(const char *data, size_t cb);
 	void assign(const char *data, const char *e);
 
+	// Scans a whole file, memory mapped if possible, see MappedFile. Returns
+	// false with errno set if it cannot be opened.
+	bool open(const char *path);
+	bool open(int fd);
+	void close();
+	bool isMapped() const { return _file && _file->mapped(); }
+
 	void operator=(const char *data) { assign(data); }
 
 	size_t tell() const;
-	size_t seek(int offset, int origin);
+	size_t seek(int64_t offset, int origin);
+
+	// Moves to the start of line n, counting from 0, using an index built over
+	// this buffer. Returns false if there is no such line or the index is for
+	// a different buffer, e.g. the window of a streaming scanner.
+	bool seekLine(const LineIndex &index, size_t n);
+	// Line of the current position, index.lines() under the same conditions.
+	size_t tellLine(const LineIndex &index) const;
 
 	const char *data() const { return _data; }
 	size_t      size() const { return (size_t)_end - (size_t)_data; }
 
-	bool eof() const { return _p >= _end; }
+	bool eof();
 	bool isNewLine() const { return _newLine != 0; }
 
 	bool seekNewLine(bool alwaysAdvance);
@@ -87,20 +147,48 @@ public:
 	bool getLnRemainder(std::string_view &res);
 	bool getTrimmedLine(std::string_view &res, bool rewind);
 
+	// Whether the last string read is a quoted one with escapes, as detected
+	// while scanning with FUSE_ESCAPE set. Strings without them need no
+	// unescape().
+	bool hasEscapes() const { return _escaped; }
+
+	// Reads a string like getString(), unescaping it into memory if needed.
+	// Strings without escapes are returned as views into the buffer.
+	template<ReadMode Mode = AnyString>
+	bool getUnescaped(std::string_view &res, std::pmr::memory_resource &memory) {
+		if (!getString<Mode>(res)) return false;
+		if (_escaped) res = unescape(res, memory);
+		return true;
+	}
+
 	template<typename T, ReadMode Mode = AnyString> bool get(T &v) {
 		std::string_view str;
 		if (!getString<Mode>(str)) return false;
 		return decodeString(str, v);
 	}
 
+	// Scratch memory for const char * values, which need a terminating NUL,
+	// and for string views of streaming scanners, whose buffer moves. Uses
+	// memory if set, otherwise a small buffer on the stack before the heap.
 	struct DecodeBuffer {
-		std::vector<std::string> temporaries;
+		char                       initial[256];
+		Arena                      arena;
+		std::pmr::memory_resource *target;
+
+		DecodeBuffer(std::pmr::memory_resource *memory = nullptr) :
+			arena(initial, sizeof(initial)), target(memory ? memory : &arena) {}
+
+		std::string_view copy(std::string_view s) {
+			char *res = static_cast<char *>(target->allocate(s.size() + 1, 1));
+			std::memcpy(res, s.data(), s.size());
+			res[s.size()] = 0;
+			return {res, s.size()};
+		}
 	};
 
 	template<typename T, ReadMode Mode = AnyString> T decode(DecodeBuffer &buf) {
 		if constexpr (std::is_same_v<T, const char *>) {
-			buf.temporaries.emplace_back(decode<std::string>(buf));
-			return buf.temporaries.back().c_str();
+			return buf.copy(decode<std::string_view, Mode>(buf)).data();
 
 		} else {
 			T rv;
@@ -118,53 +206,68 @@ public:
 		}
 	};
 
-	template<std::size_t Index, typename First, typename Next1, typename... NextN>
-	constexpr auto decodeInOrder(const DecodeBuffer &buf) {
-		return std::tuple_cat(
-			std::tuple<First>(decodeString<First>(buf.temporaries[Index])),
-			decodeInOrder<Index + 1, Next1, NextN...>(buf));
+	template<typename T>
+	bool decodeToken(std::string_view str, DecodeBuffer &buf, T &v) {
+		if constexpr (std::is_same_v<T, const char *>) {
+			v = buf.copy(str).data();
+			return true;
+		} else if constexpr (std::is_same_v<T, std::string_view>) {
+			v = _stableViews ? str : buf.copy(str);
+			return true;
+		} else
+			return decodeString(str, v);
 	}
-	template<std::size_t Index, typename First>
-	constexpr auto decodeInOrder(const DecodeBuffer &buf) {
-		return std::tuple<First>(decodeString<First>(buf.temporaries[Index]));
+
+	// Decodes one token per element of res, in order. Returns false without
+	// throwing if a token is missing or cannot be decoded.
+	template<typename... Args>
+	bool decodeInOrder(DecodeBuffer &buf, std::tuple<Args...> &res) {
+		return std::apply(
+			[this, &buf](Args &... v) {
+				std::string_view str;
+				return ((getString(str) && decodeToken(str, buf, v)) && ...);
+			},
+			res);
 	}
 
 	template<typename... Args> auto decodeInOrder(DecodeBuffer &buf) {
-		buf.temporaries.resize(sizeof...(Args));
-		for (auto &tmp : buf.temporaries) {
-			if (!get(tmp)) {
-				thrower<ScanError>() << "failed to decode value" << over;
-			}
-		}
-
-		return decodeInOrder<0, Args...>(buf);
+		std::tuple<std::decay_t<Args>...> res;
+		if (!decodeInOrder(buf, res))
+			thrower<ScanError>() << "failed to decode value" << over;
+		return res;
 	}
 
+	// Assigns all values or none. const char * values only outlive the call if
+	// memory is set. The same holds for string views on scanners whose buffer
+	// moves, e.g. StreamScanner, which fail without memory instead.
 	template<typename... T> bool getAll(T &... v) {
-		DecodeBuffer buf;
-		try {
-			auto args              = decodeInOrder<std::decay_t<T>...>(buf);
-			std::tie<T &...>(v...) = args;
-		} catch (const ScanError &) { return false; }
+		constexpr bool HasViews =
+			(std::is_same_v<std::decay_t<T>, std::string_view> || ...);
+		if (HasViews && !_stableViews && !memory) return false;
+
+		DecodeBuffer                   buf(memory);
+		std::tuple<std::decay_t<T>...> args;
+		if (!decodeInOrder(buf, args)) return false;
+		std::tie<T &...>(v...) = std::move(args);
 		return true;
 	}
 
 	template<typename RT, typename... Args>
 	RT call(std::function<RT(Args...)> target) {
-		DecodeBuffer buf;
+		DecodeBuffer buf(memory);
 
 		auto args = decodeInOrder<std::decay_t<Args>...>(buf);
 
 		return std::apply(target, args);
 	}
 	template<typename RT, typename... Args> RT call(RT target(Args...)) {
-		DecodeBuffer buf;
+		DecodeBuffer buf(memory);
 		auto         args = decodeInOrder<std::decay_t<Args>...>(buf);
 		return std::apply(target, args);
 	}
 	template<typename F, typename... Args>
 	auto call(F target, void (F::*)(Args...) const) {
-		DecodeBuffer buf;
+		DecodeBuffer buf(memory);
 		auto         args = decodeInOrder<std::decay_t<Args>...>(buf);
 		return std::apply(target, args);
 	}
@@ -174,8 +277,13 @@ public:
 	}
 
 	template<typename F>
-	static auto Call(F target, const char *str, const char *end = nullptr) {
+	static auto Call(
+		F                          target,
+		const char *               str,
+		const char *               end    = nullptr,
+		std::pmr::memory_resource *memory = nullptr) {
 		LineScanner ln;
+		ln.memory = memory;
 		if (nullptr != end) {
 			ln.assign(str, end);
 		} else {
@@ -187,16 +295,26 @@ public:
 
 struct MultilineScanner {
 protected:
-	std::string _compound;
+	std::pmr::string _compound;
+
+	void emit(std::string_view line);
 
 public:
+	// Continued lines are joined in memory, e.g. an Arena.
+	MultilineScanner(
+		std::pmr::memory_resource *memory = std::pmr::get_default_resource()) :
+		_compound(memory) {}
+
+	// Receives every logical line. If set, viewCallback is called instead, with
+	// a view that is only valid during the call but costs no allocation.
 	std::function<void(const std::string &)> callback;
+	std::function<void(std::string_view)>    viewCallback;
 
 	bool useContinuation = true;
 	bool useComments     = true;
 	char delimiter       = '\n';
 
-	void processLine(const std::string &line);
+	void processLine(std::string_view line);
 	void flush();
 };
 
@@ -40,6 +40,6 @@ void Logger::emit(const Message &msg) {
 						<< "s] " << Colored(msg.type) << " ";
 
 	if (dtCompose > -0.05) std::cerr << "(took " << dtCompose << "s) ";
-	std::cerr << msg.msg.str() << "\n";
+	std::cerr << msg.msg.view() << "\n";
 }
 } // namespace alp
@@ -23,16 +23,25 @@ Alpha4. If not, see <https://www.gnu.org/licenses/>.
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <sstream>
 #include <string>
+#include <string_view>
 namespace alp {
 class Logger : public std::enable_shared_from_this<Logger> {
 public:
 	enum struct Type { E, W, I, D, T };
 
+	typedef std::basic_stringstream<
+		char,
+		std::char_traits<char>,
+		std::pmr::polymorphic_allocator<char>>
+		Stream;
+
+	// fn is not copied, it normally refers to __FILE__.
 	struct SourcePointer {
-		std::string fn;
-		int         line = -1;
+		std::string_view fn;
+		int              line = -1;
 	};
 
 	struct Message {
@@ -46,15 +55,23 @@ public:
 		std::chrono::system_clock::time_point       tEmit;
 		Type                                        type;
 		SourcePointer                               src;
-		std::stringstream                           msg;
+		Stream                                      msg;
 
 		constexpr bool done() const { return _done; }
 
-		Message(std::shared_ptr<Logger> logger, Type type, size_t number) :
+		// The text is composed in memory, e.g. an Arena, if given.
+		Message(
+			std::shared_ptr<Logger>    logger,
+			Type                       type,
+			size_t                     number,
+			std::pmr::memory_resource *memory = nullptr) :
 			_logger(logger),
 			_messageNumber(number),
 			tBirth(std::chrono::system_clock::now()),
-			type(type) {}
+			type(type),
+			msg(
+				std::ios_base::in | std::ios_base::out,
+				memory ? memory : std::pmr::get_default_resource()) {}
 
 		Message(Message &&m) :
 			_logger(m._logger),
@@ -146,8 +163,9 @@ public:
 	static std::shared_ptr<Logger> GetPointer();
 	static Logger &                Get() { return *GetPointer(); }
 
-	template<Type type> Message startMessage() {
-		return Message(shared_from_this(), type, _messageCounter++);
+	template<Type type>
+	Message startMessage(std::pmr::memory_resource *memory = nullptr) {
+		return Message(shared_from_this(), type, _messageCounter++, memory);
 	}
 
 	virtual void emit(const Message &msg);
@@ -0,0 +1,138 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "mappedfile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define ALPHA4_HAVE_MMAP 1
+#endif
+
+namespace alp {
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+	if (this == &other) return *this;
+	close();
+	_buffer = std::move(other._buffer);
+	_data   = other._mapped ? other._data : _buffer.data();
+	_size   = other._size;
+	_open   = other._open;
+	_mapped = other._mapped;
+
+	other._data   = nullptr;
+	other._size   = 0;
+	other._open   = false;
+	other._mapped = false;
+	return *this;
+}
+
+bool MappedFile::open(const char *path) {
+	close();
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0) return false;
+	const bool ok  = open(fd);
+	const int  err = errno;
+	::close(fd);
+	errno = err;
+	return ok;
+}
+
+bool MappedFile::open(int fd) {
+	close();
+	struct stat st;
+	if (fstat(fd, &st) != 0) return false;
+
+	bool ok;
+	if (S_ISREG(st.st_mode) && st.st_size > 0) {
+		if (uint64_t(st.st_size) > SIZE_MAX) {
+			errno = EFBIG;
+			return false;
+		}
+		// mapping may still be refused, e.g. on some network file systems
+		ok = map(fd, size_t(st.st_size)) || read(fd);
+	} else
+		ok = read(fd);
+
+	_open = ok;
+	return ok;
+}
+
+bool MappedFile::map(int fd, size_t size) {
+#ifdef ALPHA4_HAVE_MMAP
+	void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) return false;
+	madvise(p, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+	// only honoured by file systems supporting large folios, harmless elsewhere
+	madvise(p, size, MADV_HUGEPAGE);
+#endif
+	_data   = static_cast<const char *>(p);
+	_size   = size;
+	_mapped = true;
+	return true;
+#else
+	(void)fd;
+	(void)size;
+	return false;
+#endif
+}
+
+bool MappedFile::read(int fd) {
+	constexpr size_t Chunk = size_t(1) << 16;
+
+	_buffer.clear();
+	size_t size = 0;
+	for (;;) {
+		if (_buffer.size() < size + Chunk)
+			_buffer.resize(std::max(_buffer.size() * 2, size + Chunk));
+		const ssize_t n = ::read(fd, _buffer.data() + size, _buffer.size() - size);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			_buffer.clear();
+			return false;
+		}
+		if (n == 0) break;
+		size += size_t(n);
+	}
+	_buffer.resize(size);
+	_buffer.shrink_to_fit();
+	_data = _buffer.data();
+	_size = size;
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef ALPHA4_HAVE_MMAP
+	if (_mapped) munmap(const_cast<char *>(_data), _size);
+#endif
+	_buffer.clear();
+	_buffer.shrink_to_fit();
+	_data   = nullptr;
+	_size   = 0;
+	_open   = false;
+	_mapped = false;
+}
+
+} // namespace alp
@@ -0,0 +1,67 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_MAPPEDFILE_HPP
+#define ALPHA4_COMMON_MAPPEDFILE_HPP
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace alp {
+
+// Read-only view of a whole file. Regular files are memory mapped with a
+// sequential access hint, so opening is O(1) and only touched pages become
+// resident. Inputs that cannot be mapped, such as pipes or character devices,
+// are read into an owned buffer instead.
+//
+// open() returns false on failure, leaving errno set.
+class MappedFile {
+protected:
+	const char *      _data   = nullptr;
+	size_t            _size   = 0;
+	bool              _open   = false;
+	bool              _mapped = false;
+	std::vector<char> _buffer;
+
+	bool map(int fd, size_t size);
+	bool read(int fd);
+
+public:
+	MappedFile() {}
+	explicit MappedFile(const char *path) { open(path); }
+	~MappedFile() { close(); }
+
+	MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+	MappedFile &operator=(MappedFile &&other) noexcept;
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const char *path);
+	// Reads from a descriptor the caller keeps ownership of, e.g. stdin.
+	bool open(int fd);
+	void close();
+
+	bool        isOpen() const { return _open; }
+	bool        mapped() const { return _mapped; }
+	const char *data() const { return _data; }
+	size_t      size() const { return _size; }
+};
+
+} // namespace alp
+#endif
@@ -0,0 +1,426 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "noise.hpp"
+
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/common/random.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <utility>
+
+// This file is compiled with -ffp-contract=off, which keeps the scalar and the
+// vector instantiations of the kernels bit-identical.
+
+namespace alp {
+namespace {
+
+using namespace simd;
+
+struct ScalarOps {
+	typedef float   F;
+	typedef int32_t I;
+
+	static ALPHA4_SIMD_INLINE I toI(F x) { return I(x); }
+	static ALPHA4_SIMD_INLINE F toF(I x) { return F(x); }
+	static ALPHA4_SIMD_INLINE I lookup(const uint8_t *perm, I idx) {
+		return perm[idx];
+	}
+};
+
+template<size_t B> struct PackOps {
+	typedef pack_t<float, B>                F;
+	typedef typename Pack<float, B>::index I;
+
+	static ALPHA4_SIMD_INLINE I toI(const F &x) {
+		return __builtin_convertvector(x, I);
+	}
+	static ALPHA4_SIMD_INLINE F toF(const I &x) {
+		return __builtin_convertvector(x, F);
+	}
+	static ALPHA4_SIMD_INLINE I lookup(const uint8_t *perm, const I &idx) {
+		I res;
+		for (size_t l = 0; l < Lanes<float, B>; l++)
+			res[l] = perm[idx[l]];
+		return res;
+	}
+};
+
+template<typename Ops>
+ALPHA4_SIMD_INLINE typename Ops::I floorInt(const typename Ops::F &x) {
+	const typename Ops::I i = Ops::toI(x);
+	return Ops::toF(i) > x ? i - 1 : i;
+}
+
+template<typename F> ALPHA4_SIMD_INLINE F fade(const F &t) {
+	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+template<typename F>
+ALPHA4_SIMD_INLINE F lerp(const F &a, const F &b, const F &t) {
+	return a + t * (b - a);
+}
+
+// Gradients of Gustavson's reference implementations, the midpoints of the
+// edges of the unit hypercube, and (±1, ±2) in 2D.
+template<typename Ops, size_t D>
+ALPHA4_SIMD_INLINE typename Ops::F
+gradient(const typename Ops::I &hash, const typename Ops::F *d) {
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	I h;
+
+	if constexpr (D == 2) {
+		h         = hash & 7;
+		const F u = h < 4 ? d[0] : d[1];
+		const F v = h < 4 ? d[1] : d[0];
+		return ((h & 1) != 0 ? -u : u) + ((h & 2) != 0 ? -2.0f * v : 2.0f * v);
+	} else if constexpr (D == 3) {
+		h         = hash & 15;
+		const F u = h < 8 ? d[0] : d[1];
+		const F v = h < 4 ? d[1] : ((h == 12) | (h == 14)) != 0 ? d[0] : d[2];
+		return ((h & 1) != 0 ? -u : u) + ((h & 2) != 0 ? -v : v);
+	} else {
+		h         = hash & 31;
+		const F u = h < 24 ? d[0] : d[1];
+		const F v = h < 16 ? d[1] : d[2];
+		const F w = h < 8 ? d[2] : d[3];
+		return ((h & 1) != 0 ? -u : u) + ((h & 2) != 0 ? -v : v)
+				 + ((h & 4) != 0 ? -w : w);
+	}
+}
+
+// Value and Perlin noise, interpolating the 2^D lattice corners around p.
+template<typename Ops, NoiseType Type, size_t D>
+ALPHA4_SIMD_INLINE typename Ops::F
+latticeNoise(const uint8_t *perm, const typename Ops::F *p) {
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	// peak amplitudes of the gradient noise, scaling it to about [-1, 1]
+	constexpr const float Scale[5] = {0, 0, 0.507f, 0.936f, 0.87f};
+
+	I i[D];
+	F f[D], u[D];
+	for (size_t k = 0; k < D; k++) {
+		i[k] = floorInt<Ops>(p[k]);
+		f[k] = p[k] - Ops::toF(i[k]);
+		u[k] = fade(f[k]);
+		i[k] = i[k] & 255;
+	}
+
+	F v[size_t(1) << D];
+	for (size_t c = 0; c < (size_t(1) << D); c++) {
+		I h = I{};
+		F d[D];
+		for (size_t k = 0; k < D; k++) {
+			const int32_t bit = int32_t((c >> k) & 1);
+			h                 = Ops::lookup(perm, h + i[k] + bit);
+			d[k]              = f[k] - float(bit);
+		}
+		if constexpr (Type == NoiseType::Value)
+			v[c] = Ops::toF(h) * (2.0f / 255.0f) - 1.0f;
+		else
+			v[c] = gradient<Ops, D>(h, d);
+	}
+
+	// interpolate along one axis at a time, bit k of the corner index first
+	for (size_t k = 0; k < D; k++) {
+		for (size_t c = 0; c < (size_t(1) << (D - k - 1)); c++)
+			v[c] = lerp(v[2 * c], v[2 * c + 1], u[k]);
+	}
+	if constexpr (Type == NoiseType::Value)
+		return v[0];
+	else
+		return v[0] * Scale[D];
+}
+
+// Simplex noise, summing the radial kernels of the D + 1 simplex corners.
+template<typename Ops, size_t D>
+ALPHA4_SIMD_INLINE typename Ops::F
+simplexNoise(const uint8_t *perm, const typename Ops::F *p) {
+	typedef typename Ops::F F;
+	typedef typename Ops::I I;
+
+	// skew (sqrt(D + 1) - 1) / D and unskew (1 - 1 / sqrt(D + 1)) / D factors,
+	// kernel radii and output scales
+	constexpr const float Skew[5]   = {0, 0, 0.36602540f, 1.0f / 3, 0.30901699f};
+	constexpr const float Unskew[5] = {0, 0, 0.21132487f, 1.0f / 6, 0.13819660f};
+	constexpr const float Radius[5] = {0, 0, 0.5f, 0.6f, 0.6f};
+	constexpr const float Scale[5]  = {0, 0, 40.0f, 32.0f, 27.0f};
+
+	F s = p[0];
+	for (size_t k = 1; k < D; k++)
+		s = s + p[k];
+	s = s * Skew[D];
+
+	I i[D];
+	F x0[D], t = F{};
+	for (size_t k = 0; k < D; k++) {
+		i[k] = floorInt<Ops>(p[k] + s);
+		t    = t + Ops::toF(i[k]);
+	}
+	t = t * Unskew[D];
+	for (size_t k = 0; k < D; k++) {
+		x0[k] = p[k] - (Ops::toF(i[k]) - t);
+		i[k]  = i[k] & 255;
+	}
+
+	// rank[k] counts the components larger than x0[k]; corner m steps along the
+	// m largest ones
+	I rank[D];
+	for (size_t k = 0; k < D; k++)
+		rank[k] = I{};
+	for (size_t j = 0; j < D; j++) {
+		for (size_t k = j + 1; k < D; k++) {
+			const I greater = x0[j] > x0[k] ? I{} + 1 : I{};
+			rank[k]         = rank[k] + greater;
+			rank[j]         = rank[j] + (1 - greater);
+		}
+	}
+
+	F n = F{};
+	for (size_t m = 0; m <= D; m++) {
+		I h = I{};
+		F x[D], r = F{} + Radius[D];
+		for (size_t k = 0; k < D; k++) {
+			const I step = rank[k] < int32_t(m) ? I{} + 1 : I{};
+			h            = Ops::lookup(perm, h + i[k] + step);
+			x[k]         = x0[k] - Ops::toF(step) + float(m) * Unskew[D];
+			r            = r - x[k] * x[k];
+		}
+		r = r > 0 ? r : F{};
+		r = r * r;
+		n = n + r * r * gradient<Ops, D>(h, x);
+	}
+	return n * Scale[D];
+}
+
+template<typename Ops, NoiseType Type, size_t D>
+ALPHA4_SIMD_INLINE typename Ops::F fractalNoise(
+	const uint8_t *perm, const typename Ops::F *p, const NoiseOctaves &octaves) {
+	typedef typename Ops::F F;
+
+	F     sum       = F{};
+	float amplitude = 1, frequency = 1, total = 0;
+	for (unsigned o = 0; o < std::max(octaves.count, 1u); o++) {
+		F q[D];
+		for (size_t k = 0; k < D; k++)
+			q[k] = p[k] * frequency;
+
+		F v;
+		if constexpr (Type == NoiseType::Simplex)
+			v = simplexNoise<Ops, D>(perm, q);
+		else
+			v = latticeNoise<Ops, Type, D>(perm, q);
+
+		sum        = sum + v * amplitude;
+		total     += amplitude;
+		amplitude *= octaves.gain;
+		frequency *= octaves.lacunarity;
+	}
+	return sum / total;
+}
+
+// Coordinate k of point i is coords[k][i * stride].
+template<NoiseType Type, size_t D, size_t B>
+ALPHA4_SIMD_INLINE void noisePacks(
+	const uint8_t *     perm,
+	const float *const *coords,
+	size_t              stride,
+	float *             res,
+	size_t              begin,
+	size_t              end,
+	const NoiseOctaves &octaves) {
+	for (size_t i = begin; i < end; i += Lanes<float, B>) {
+		pack_t<float, B> p[D];
+		for (size_t k = 0; k < D; k++) {
+			const float *src = coords[k] + i * stride;
+			p[k] = stride == 1 ? load<float, B>(src) : gather<float, B>(src, stride);
+		}
+		store<float, B>(
+			res + i, fractalNoise<PackOps<B>, Type, D>(perm, p, octaves));
+	}
+}
+
+template<NoiseType Type, size_t D>
+void noisePacksGeneric(
+	const uint8_t *     perm,
+	const float *const *coords,
+	size_t              stride,
+	float *             res,
+	size_t              begin,
+	size_t              end,
+	const NoiseOctaves &octaves) {
+	noisePacks<Type, D, PackBytes<Isa::Generic>>(
+		perm, coords, stride, res, begin, end, octaves);
+}
+
+#ifdef ALPHA4_SIMD_X86
+template<NoiseType Type, size_t D>
+ALPHA4_TARGET_AVX2 void noisePacksAVX2(
+	const uint8_t *     perm,
+	const float *const *coords,
+	size_t              stride,
+	float *             res,
+	size_t              begin,
+	size_t              end,
+	const NoiseOctaves &octaves) {
+	noisePacks<Type, D, PackBytes<Isa::AVX2>>(
+		perm, coords, stride, res, begin, end, octaves);
+}
+
+template<NoiseType Type, size_t D>
+ALPHA4_TARGET_AVX512 void noisePacksAVX512(
+	const uint8_t *     perm,
+	const float *const *coords,
+	size_t              stride,
+	float *             res,
+	size_t              begin,
+	size_t              end,
+	const NoiseOctaves &octaves) {
+	noisePacks<Type, D, PackBytes<Isa::AVX512>>(
+		perm, coords, stride, res, begin, end, octaves);
+}
+#endif
+
+template<NoiseType Type, size_t D>
+float noiseAt(
+	const uint8_t *perm, const float *p, const NoiseOctaves &octaves) {
+	return fractalNoise<ScalarOps, Type, D>(perm, p, octaves);
+}
+
+template<NoiseType Type, size_t D>
+void noiseAll(
+	const uint8_t *     perm,
+	const float *const *coords,
+	size_t              stride,
+	float *             res,
+	size_t              count,
+	const NoiseOctaves &octaves) {
+	constexpr size_t W    = MaxLanes<float>;
+	const size_t     full = count - count % W;
+
+	auto packs = ALPHA4_SIMD_SELECT(noisePacks, <Type, D>);
+
+	parallelFor(0, full / W, 256, [&](size_t b, size_t e) {
+		packs(perm, coords, stride, res, b * W, e * W, octaves);
+	});
+
+	for (size_t i = full; i < count; i++) {
+		float p[D];
+		for (size_t k = 0; k < D; k++)
+			p[k] = coords[k][i * stride];
+		res[i] = noiseAt<Type, D>(perm, p, octaves);
+	}
+}
+
+template<size_t D>
+void noiseAll(
+	NoiseType           type,
+	const uint8_t *     perm,
+	const float *const *coords,
+	size_t              stride,
+	float *             res,
+	size_t              count,
+	const NoiseOctaves &octaves) {
+	switch (type) {
+		case NoiseType::Value:
+			noiseAll<NoiseType::Value, D>(perm, coords, stride, res, count, octaves);
+			break;
+		case NoiseType::Perlin:
+			noiseAll<NoiseType::Perlin, D>(perm, coords, stride, res, count, octaves);
+			break;
+		case NoiseType::Simplex:
+			noiseAll<NoiseType::Simplex, D>(
+				perm, coords, stride, res, count, octaves);
+			break;
+	}
+}
+
+} // namespace
+
+Noise::Noise(NoiseType type, uint64_t seed) : _type(type) { this->seed(seed); }
+
+void Noise::seed(uint64_t seed) {
+	_seed = seed;
+
+	Xoshiro256 rng(seed);
+	for (unsigned i = 0; i < 256; i++)
+		_perm[i] = uint8_t(i);
+	for (unsigned i = 255; i > 0; i--)
+		std::swap(_perm[i], _perm[rng.uniformInt(i + 1)]);
+	for (unsigned i = 0; i < 256; i++)
+		_perm[i + 256] = _perm[i];
+}
+
+template<size_t D>
+float Noise::operator()(
+	const Vector<D, float> &p, const NoiseOctaves &octaves) const {
+	switch (_type) {
+		case NoiseType::Value:
+			return noiseAt<NoiseType::Value, D>(_perm, p.data(), octaves);
+		case NoiseType::Perlin:
+			return noiseAt<NoiseType::Perlin, D>(_perm, p.data(), octaves);
+		case NoiseType::Simplex:
+			return noiseAt<NoiseType::Simplex, D>(_perm, p.data(), octaves);
+	}
+	return 0;
+}
+
+template<size_t D>
+void Noise::evaluate(
+	const Vector<D, float> *p,
+	float *                 res,
+	size_t                  count,
+	const NoiseOctaves &    octaves) const {
+	if (count == 0) return;
+	const float *coords[D];
+	for (size_t k = 0; k < D; k++)
+		coords[k] = p[0].data() + k;
+	noiseAll<D>(_type, _perm, coords, D, res, count, octaves);
+}
+
+template<size_t D>
+void Noise::evaluate(
+	const PointArray<D> &p, float *res, const NoiseOctaves &octaves) const {
+	noiseAll<D>(_type, _perm, p.coords, 1, res, p.count, octaves);
+}
+
+template float
+Noise::operator()(const Vector<2, float> &, const NoiseOctaves &) const;
+template float
+Noise::operator()(const Vector<3, float> &, const NoiseOctaves &) const;
+template float
+Noise::operator()(const Vector<4, float> &, const NoiseOctaves &) const;
+
+template void Noise::evaluate(
+	const Vector<2, float> *, float *, size_t, const NoiseOctaves &) const;
+template void Noise::evaluate(
+	const Vector<3, float> *, float *, size_t, const NoiseOctaves &) const;
+template void Noise::evaluate(
+	const Vector<4, float> *, float *, size_t, const NoiseOctaves &) const;
+
+template void
+Noise::evaluate(const PointArray<2> &, float *, const NoiseOctaves &) const;
+template void
+Noise::evaluate(const PointArray<3> &, float *, const NoiseOctaves &) const;
+template void
+Noise::evaluate(const PointArray<4> &, float *, const NoiseOctaves &) const;
+
+} // namespace alp
@@ -0,0 +1,89 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_NOISE_HPP
+#define ALPHA4_COMMON_NOISE_HPP
+#include "alpha4/types/vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace alp {
+
+enum class NoiseType : uint8_t { Value, Perlin, Simplex };
+
+// Fractal sum over octaves, each scaled by lacunarity in frequency and by gain
+// in amplitude. The sum is divided by the total amplitude, so the range of the
+// result stays that of a single octave.
+struct NoiseOctaves {
+	unsigned count      = 1;
+	float    lacunarity = 2;
+	float    gain       = 0.5f;
+};
+
+// Structure-of-arrays view over D dimensional points.
+template<size_t D> struct PointArray {
+	const float *coords[D];
+	size_t       count;
+};
+
+// Gradient (Perlin, simplex) and value noise in 2 to 4 dimensions, hashed
+// through a seeded permutation table. The result is roughly in [-1, 1].
+//
+// Batches are evaluated one pack of points at a time, whose width depends on
+// the instruction set selected at runtime: 16 points with AVX-512, 8 otherwise.
+// Scalar and batch evaluation share their kernels and are compiled without
+// floating point contraction, so both produce bit-identical results on every
+// target. Coordinates are expected to
+// stay below 2^31 in magnitude.
+class Noise {
+protected:
+	uint8_t   _perm[512];
+	NoiseType _type;
+	uint64_t  _seed;
+
+public:
+	explicit Noise(NoiseType type = NoiseType::Perlin, uint64_t seed = 0);
+
+	// Reshuffles the permutation table.
+	void     seed(uint64_t seed);
+	uint64_t seed() const { return _seed; }
+
+	NoiseType type() const { return _type; }
+	void      setType(NoiseType type) { _type = type; }
+
+	const uint8_t *permutation() const { return _perm; }
+
+	template<size_t D>
+	float operator()(
+		const Vector<D, float> &p, const NoiseOctaves &octaves = {}) const;
+
+	template<size_t D>
+	void evaluate(
+		const Vector<D, float> *p,
+		float *                 res,
+		size_t                  count,
+		const NoiseOctaves &    octaves = {}) const;
+	template<size_t D>
+	void evaluate(
+		const PointArray<D> &p,
+		float *              res,
+		const NoiseOctaves & octaves = {}) const;
+};
+
+} // namespace alp
+#endif
@@ -0,0 +1,48 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_PARALLEL_HPP
+#define ALPHA4_COMMON_PARALLEL_HPP
+#include "alpha4/common/threadpool.hpp"
+
+#include <cstddef>
+
+namespace alp {
+
+// Calls fn(chunkBegin, chunkEnd) on disjoint chunks of at least grain items
+// covering [begin, end), on the global ThreadPool. Runs inline if there is only
+// a single chunk. fn must not throw.
+template<typename F>
+void parallelFor(size_t begin, size_t end, size_t grain, const F &fn) {
+	ThreadPool::Global().parallelFor(begin, end, grain, fn);
+}
+
+// See ThreadPool::parallelReduce().
+template<typename T, typename Map, typename Reduce>
+T parallelReduce(
+	size_t        begin,
+	size_t        end,
+	size_t        grain,
+	T             init,
+	const Map &   map,
+	const Reduce &reduce) {
+	return ThreadPool::Global().parallelReduce(
+		begin, end, grain, init, map, reduce);
+}
+
+} // namespace alp
+#endif
@@ -0,0 +1,266 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "parallelscanner.hpp"
+
+#include "alpha4/common/simd.hpp"
+
+#include <algorithm>
+
+namespace alp {
+
+namespace {
+
+using namespace simd;
+
+// Quote state between two bytes: outside of quotes, flag tells whether the
+// next byte starts a token; inside, flag tells whether it is escaped.
+struct QuoteState {
+	char quote;
+	bool flag;
+
+	bool operator==(const QuoteState &) const = default;
+};
+
+constexpr const QuoteState StartStates[] = {
+	{0, true},
+	{0, false},
+	{'"', false},
+	{'"', true},
+	{'\'', false},
+	{'\'', true},
+};
+constexpr const size_t StateCount = std::size(StartStates);
+
+const auto IsQuote = [](const auto &c) ALPHA4_SIMD_LAMBDA {
+	return maskOr(c == '"', c == '\'');
+};
+const auto IsQuoteOrNewLine = [](const auto &c) ALPHA4_SIMD_LAMBDA {
+	return maskOr(c == '"', c == '\'', c == '\n', c == '\r');
+};
+
+size_t stateIndex(const QuoteState &s) {
+	for (size_t i = 0; i < StateCount; i++)
+		if (StartStates[i] == s) return i;
+	return 0;
+}
+
+// Advances s over [p, end). With stopAtNewLine, stops at the first newline
+// outside of quotes and returns its position, otherwise returns end.
+template<size_t W>
+ALPHA4_SIMD_INLINE const char *advance(
+	QuoteState &s, const char *p, const char *end, bool doesc,
+	bool stopAtNewLine) {
+	while (p < end) {
+		if (s.quote) {
+			if (s.flag) {
+				s.flag = false;
+				p++;
+				continue;
+			}
+			const char quote      = s.quote;
+			const auto isQuote    = [quote](const auto &c) { return c == quote; };
+			const auto isQuoteEsc = [quote](const auto &c) ALPHA4_SIMD_LAMBDA {
+				return maskOr(c == quote, c == '\\');
+			};
+			const char *q = doesc ? findByte<W>(p, end, isQuoteEsc)
+			                      : findByte<W>(p, end, isQuote);
+			if (q >= end) return end;
+			if (*q == quote)
+				s = {0, true};
+			else
+				s.flag = true;
+			p = q + 1;
+			continue;
+		}
+
+		if (s.flag && ((*p == '"') || (*p == '\''))) {
+			s = {*p, false};
+			p++;
+			continue;
+		}
+		const char *q = stopAtNewLine ? findByte<W>(p, end, IsQuoteOrNewLine)
+		                              : findByte<W>(p, end, IsQuote);
+		if (q >= end) {
+			s.flag = end[-1] <= ' ';
+			return end;
+		}
+		if ((*q == '\n') || (*q == '\r')) return q;
+		// quotes only open a string at the start of a token
+		if (q == p ? s.flag : q[-1] <= ' ')
+			s = {*q, false};
+		else
+			s.flag = false;
+		p = q + 1;
+	}
+	return end;
+}
+
+const char *advanceGeneric(
+	QuoteState &s, const char *p, const char *end, bool doesc,
+	bool stopAtNewLine) {
+	return advance<ByteLanes<Isa::Generic>>(s, p, end, doesc, stopAtNewLine);
+}
+
+#ifdef ALPHA4_SIMD_X86
+ALPHA4_TARGET_AVX2 const char *advanceAVX2(
+	QuoteState &s, const char *p, const char *end, bool doesc,
+	bool stopAtNewLine) {
+	return advance<ByteLanes<Isa::AVX2>>(s, p, end, doesc, stopAtNewLine);
+}
+
+ALPHA4_TARGET_AVX512 const char *advanceAVX512(
+	QuoteState &s, const char *p, const char *end, bool doesc,
+	bool stopAtNewLine) {
+	return advance<ByteLanes<Isa::AVX512>>(s, p, end, doesc, stopAtNewLine);
+}
+#endif
+
+template<size_t W>
+ALPHA4_SIMD_INLINE const char *findNewLine(const char *p, const char *end) {
+	return findByte<W>(p, end, [](const auto &c) ALPHA4_SIMD_LAMBDA {
+		return maskOr(c == '\n', c == '\r');
+	});
+}
+
+const char *findNewLineGeneric(const char *p, const char *end) {
+	return findNewLine<ByteLanes<Isa::Generic>>(p, end);
+}
+
+#ifdef ALPHA4_SIMD_X86
+ALPHA4_TARGET_AVX2 const char *findNewLineAVX2(const char *p, const char *end) {
+	return findNewLine<ByteLanes<Isa::AVX2>>(p, end);
+}
+ALPHA4_TARGET_AVX512 const char *
+	findNewLineAVX512(const char *p, const char *end) {
+	return findNewLine<ByteLanes<Isa::AVX512>>(p, end);
+}
+#endif
+
+template<size_t W>
+ALPHA4_SIMD_INLINE size_t countLineBreaks(const char *p, const char *end) {
+	return countBytes<W>(p, end, [](const auto &c) ALPHA4_SIMD_LAMBDA {
+		return maskOr(c == '\n', c == '\r');
+	});
+}
+
+template<size_t W>
+ALPHA4_SIMD_INLINE size_t countLineEnds(const char *p, const char *end) {
+	size_t res = 0;
+	// the next byte tells whether a '\r' is followed by '\n'
+	for (; size_t(end - p) > W; p += W) {
+		const bytes_t<W> c = loadBytes<W>(p), next = loadBytes<W>(p + 1);
+		res += size_t(__builtin_popcountll(
+			bitmask<W>(maskOr(c == '\n', maskAnd(c == '\r', next != '\n')))));
+	}
+	for (; p < end; p++)
+		if (*p == '\n' || (*p == '\r' && (p + 1 == end || p[1] != '\n'))) res++;
+	return res;
+}
+
+size_t countLineBreaksGeneric(const char *p, const char *end) {
+	return countLineBreaks<ByteLanes<Isa::Generic>>(p, end);
+}
+size_t countLineEndsGeneric(const char *p, const char *end) {
+	return countLineEnds<ByteLanes<Isa::Generic>>(p, end);
+}
+
+#ifdef ALPHA4_SIMD_X86
+ALPHA4_TARGET_AVX2 size_t countLineBreaksAVX2(const char *p, const char *end) {
+	return countLineBreaks<ByteLanes<Isa::AVX2>>(p, end);
+}
+ALPHA4_TARGET_AVX2 size_t countLineEndsAVX2(const char *p, const char *end) {
+	return countLineEnds<ByteLanes<Isa::AVX2>>(p, end);
+}
+ALPHA4_TARGET_AVX512 size_t
+	countLineBreaksAVX512(const char *p, const char *end) {
+	return countLineBreaks<ByteLanes<Isa::AVX512>>(p, end);
+}
+ALPHA4_TARGET_AVX512 size_t
+	countLineEndsAVX512(const char *p, const char *end) {
+	return countLineEnds<ByteLanes<Isa::AVX512>>(p, end);
+}
+#endif
+
+} // namespace
+
+size_t countLineBreaks(const char *p, const char *end) {
+	return ALPHA4_SIMD_SELECT(countLineBreaks)(p, end);
+}
+
+size_t countLineEnds(const char *p, const char *end) {
+	return ALPHA4_SIMD_SELECT(countLineEnds)(p, end);
+}
+
+const char *findRecordEnd(
+	const char *p, const char *end, const ParallelScanOptions &options) {
+	if (!options.quoteAware) return ALPHA4_SIMD_SELECT(findNewLine)(p, end);
+	QuoteState s = {0, true};
+	return ALPHA4_SIMD_SELECT(advance)(
+		s, p, end, options.flags & LineScanner::FUSE_ESCAPE, true);
+}
+
+std::vector<size_t> splitRecords(
+	const char *data, size_t size, const ParallelScanOptions &options) {
+	const size_t chunkSize = std::max<size_t>(options.chunkSize, 1);
+	const size_t count = std::max<size_t>((size + chunkSize / 2) / chunkSize, 1);
+	const bool   doesc = options.flags & LineScanner::FUSE_ESCAPE;
+	const char * end   = data + size;
+	ThreadPool & pool  = options.pool ? *options.pool : ThreadPool::Global();
+
+	auto nominal = [&](size_t c) { return data + size * c / count; };
+
+	// quote state at every nominal boundary
+	std::vector<QuoteState> states(count, QuoteState{0, true});
+	if (options.quoteAware && count > 1) {
+		// end state of every chunk for every possible start state
+		std::vector<QuoteState> ends((count - 1) * StateCount);
+		auto advanceFn = ALPHA4_SIMD_SELECT(advance);
+		pool.parallelFor(0, count - 1, 1, [&](size_t b, size_t e) {
+			for (size_t c = b; c < e; c++) {
+				for (size_t i = 0; i < StateCount; i++) {
+					QuoteState s = StartStates[i];
+					advanceFn(s, nominal(c), nominal(c + 1), doesc, false);
+					ends[c * StateCount + i] = s;
+				}
+			}
+		});
+		for (size_t c = 1; c < count; c++)
+			states[c] = ends[(c - 1) * StateCount + stateIndex(states[c - 1])];
+	}
+
+	std::vector<size_t> res(1, 0);
+	res.reserve(count + 1);
+	for (size_t c = 1; c < count; c++) {
+		const char *p = nominal(c);
+		if (options.quoteAware) {
+			QuoteState s = states[c];
+			p = ALPHA4_SIMD_SELECT(advance)(s, p, end, doesc, true);
+		} else {
+			// a boundary right after a newline already starts a line
+			if ((p[-1] != '\n') && (p[-1] != '\r'))
+				p = ALPHA4_SIMD_SELECT(findNewLine)(p, end);
+		}
+		const size_t offset = std::max(size_t(p - data), res.back());
+		if (offset > res.back() && offset < size) res.push_back(offset);
+	}
+	res.push_back(size);
+	return res;
+}
+
+} // namespace alp
@@ -0,0 +1,141 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_PARALLELSCANNER_HPP
+#define ALPHA4_COMMON_PARALLELSCANNER_HPP
+#include "alpha4/common/linescanner.hpp"
+#include "alpha4/common/threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace alp {
+
+struct ParallelScanOptions {
+	// approximate bytes per task
+	size_t chunkSize = size_t(1) << 20;
+	// deliver results in input order, otherwise as chunks complete
+	bool ordered = true;
+	// newlines inside quoted strings do not end a record
+	bool quoteAware = false;
+	// LineScanner flags, FUSE_ESCAPE also applies to quote-aware splitting
+	uint32_t    flags = 0;
+	ThreadPool *pool  = nullptr;
+};
+
+// Offsets of chunks of about chunkSize bytes covering [data, data + size), each
+// starting at the beginning of a record, followed by size. Records are lines,
+// or with quoteAware, lines whose newlines outside of quoted strings end them,
+// with quotes recognized at token starts as LineScanner does. Quote states at
+// the nominal boundaries are determined speculatively in parallel.
+std::vector<size_t> splitRecords(
+	const char *data, size_t size, const ParallelScanOptions &options);
+
+// End of the record starting at p, i.e. its terminating newline or end.
+const char *findRecordEnd(
+	const char *p, const char *end, const ParallelScanOptions &options);
+
+// Number of '\n' and '\r' bytes, i.e. an upper bound for the line breaks.
+size_t countLineBreaks(const char *p, const char *end);
+
+// Number of line breaks as they end records, '\n', '\r' or "\r\n". A '\r'
+// at end counts on its own.
+size_t countLineEnds(const char *p, const char *end);
+
+// Calls fn(LineScanner &record) for every record of [data, data + size) on
+// the thread pool, each time with a scanner over just that record. Empty
+// lines are skipped, as LineScanner::seekNewLine() does. If fn returns a
+// value, it is passed to sink, which is never called concurrently, in input
+// order if options.ordered is set. fn must not throw.
+template<typename F, typename Sink>
+void parallelScan(
+	const char *               data,
+	size_t                     size,
+	const F &                  fn,
+	const Sink &               sink,
+	const ParallelScanOptions &options = ParallelScanOptions()) {
+	typedef std::invoke_result_t<const F &, LineScanner &> R;
+	constexpr bool HasResult = !std::is_void_v<R>;
+	typedef std::conditional_t<HasResult, R, char> Result;
+
+	ThreadPool &pool = options.pool ? *options.pool : ThreadPool::Global();
+	const std::vector<size_t> chunks = splitRecords(data, size, options);
+	const size_t              count  = chunks.size() - 1;
+
+	// results of chunks completed ahead of the next one in order
+	std::vector<std::vector<Result>> pending(HasResult ? count : 0);
+	std::vector<uint8_t>             done(count, 0);
+	size_t                           next = 0;
+	std::mutex                       mutex;
+
+	auto runChunk = [&](size_t c) {
+		std::vector<Result> results;
+		LineScanner         ln;
+		ln.flags = options.flags;
+
+		const char *p = data + chunks[c], *end = data + chunks[c + 1];
+		while (p < end) {
+			if (*p == '\n' || *p == '\r') {
+				p++;
+				continue;
+			}
+			const char *e = findRecordEnd(p, end, options);
+			ln.assign(p, e);
+			if constexpr (HasResult)
+				results.push_back(fn(ln));
+			else
+				fn(ln);
+			p = e;
+		}
+		if constexpr (HasResult) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!options.ordered) {
+				for (auto &r : results)
+					sink(std::move(r));
+				return;
+			}
+			pending[c] = std::move(results);
+			done[c]    = 1;
+			for (; next < count && done[next]; next++) {
+				for (auto &r : pending[next])
+					sink(std::move(r));
+				pending[next] = std::vector<Result>();
+			}
+		}
+	};
+
+	pool.parallelFor(0, count, 1, [&](size_t b, size_t e) {
+		for (size_t c = b; c < e; c++)
+			runChunk(c);
+	});
+}
+
+template<typename F>
+void parallelScan(
+	const char *               data,
+	size_t                     size,
+	const F &                  fn,
+	const ParallelScanOptions &options = ParallelScanOptions()) {
+	parallelScan(data, size, fn, [](auto &&) {}, options);
+}
+
+} // namespace alp
+#endif
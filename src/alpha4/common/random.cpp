@@ -0,0 +1,257 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "random.hpp"
+
+#include "alpha4/common/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <random>
+
+namespace alp {
+namespace {
+
+std::mutex sequenceMutex;
+bool       sequenceSeeded = false;
+rng_t      sequence;
+
+typedef uint64_t Lanes64 __attribute__((vector_size(64)));
+typedef uint32_t Lanes32 __attribute__((vector_size(64)));
+typedef double   LanesD __attribute__((vector_size(64)));
+typedef float    LanesF __attribute__((vector_size(64)));
+
+static_assert(sizeof(Lanes64) == RandomBatch::Lanes * sizeof(uint64_t));
+
+enum class Output { Raw, Float, Double };
+
+constexpr size_t blockSize(Output out) {
+	return out == Output::Float ? 2 * RandomBatch::Lanes : RandomBatch::Lanes;
+}
+
+// Advances all lanes blocks times, converting each block of raw values like
+// rng_float/rng_double but with the mantissa filled from the high bits.
+typedef uint64_t (*LaneState)[RandomBatch::Lanes];
+
+template<Output Out, typename R>
+ALPHA4_SIMD_INLINE void generate(LaneState state, R *res, size_t blocks) {
+	Lanes64 s[4];
+	std::memcpy(s, state, sizeof(s));
+
+	for (size_t b = 0; b < blocks; b++) {
+		const Lanes64 x = s[0] + s[3];
+		const Lanes64 r = ((x << 23) | (x >> 41)) + s[0];
+		const Lanes64 t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = (s[3] << 45) | (s[3] >> 19);
+
+		R *dst = res + b * blockSize(Out);
+		if constexpr (Out == Output::Raw) {
+			std::memcpy(dst, &r, sizeof(r));
+		} else if constexpr (Out == Output::Double) {
+			const Lanes64 bits = (r >> 12) | 0x3ff0000000000000ull;
+			const LanesD  v    = (LanesD)bits - 1.0;
+			std::memcpy(dst, &v, sizeof(v));
+		} else {
+			const Lanes32 bits = ((Lanes32)r >> 9) | 0x3f800000u;
+			const LanesF  v    = (LanesF)bits - 1.0f;
+			std::memcpy(dst, &v, sizeof(v));
+		}
+	}
+
+	std::memcpy(state, s, sizeof(s));
+}
+
+template<Output Out, typename R>
+void generateGeneric(LaneState state, R *res, size_t blocks) {
+	generate<Out>(state, res, blocks);
+}
+
+#ifdef ALPHA4_SIMD_X86
+template<Output Out, typename R>
+ALPHA4_TARGET_AVX2 void generateAVX2(LaneState state, R *res, size_t blocks) {
+	generate<Out>(state, res, blocks);
+}
+
+template<Output Out, typename R>
+ALPHA4_TARGET_AVX512 void
+generateAVX512(LaneState state, R *res, size_t blocks) {
+	generate<Out>(state, res, blocks);
+}
+#endif
+
+template<Output Out, typename R>
+void generateAll(LaneState state, R *res, size_t count) {
+	constexpr size_t B    = blockSize(Out);
+	const size_t     full = count / B;
+
+	auto blocks = ALPHA4_SIMD_SELECT(generate, <Out, R>);
+
+	blocks(state, res, full);
+	if (full * B < count) {
+		R tail[B];
+		blocks(state, tail, 1);
+		std::copy(tail, tail + count - full * B, res + full * B);
+	}
+}
+
+} // namespace
+
+void RandomBatch::next(uint64_t *res, size_t count) {
+	generateAll<Output::Raw>(_state, res, count);
+}
+void RandomBatch::uniform(float *res, size_t count) {
+	generateAll<Output::Float>(_state, res, count);
+}
+void RandomBatch::uniform(double *res, size_t count) {
+	generateAll<Output::Double>(_state, res, count);
+}
+void RandomBatch::uniform(float *res, size_t count, float lo, float hi) {
+	uniform(res, count);
+	for (size_t i = 0; i < count; i++)
+		res[i] = lo + (hi - lo) * res[i];
+}
+void RandomBatch::uniform(double *res, size_t count, double lo, double hi) {
+	uniform(res, count);
+	for (size_t i = 0; i < count; i++)
+		res[i] = lo + (hi - lo) * res[i];
+}
+
+void RandomBatch::uniformInt(uint32_t *res, size_t count, uint32_t n) {
+	constexpr size_t Block = 256;
+	uint64_t         raw[Block];
+	for (size_t b = 0; b < count; b += Block) {
+		const size_t m = std::min(Block, count - b);
+		next(raw, m);
+		for (size_t i = 0; i < m; i++) {
+			// high word of the 96 bit product raw * n
+			const uint64_t hi = (raw[i] >> 32) * n;
+			const uint64_t lo = ((raw[i] & 0xffffffffu) * n) >> 32;
+			res[b + i]        = uint32_t((hi + lo) >> 32);
+		}
+	}
+}
+
+template<typename T>
+void RandomBatch::inBox(
+	Vector<3, T> *      res,
+	size_t              count,
+	const Vector<3, T> &lo,
+	const Vector<3, T> &hi) {
+	uniform(res->data(), count * 3);
+	for (size_t i = 0; i < count; i++) {
+		for (size_t c = 0; c < 3; c++)
+			res[i][c] = lo[c] + (hi[c] - lo[c]) * res[i][c];
+	}
+}
+
+template<typename T>
+void RandomBatch::onUnitSphere(Vector<3, T> *res, size_t count) {
+	constexpr size_t Block = 256;
+	T                z[Block], phi[Block], s[Block], c[Block];
+	for (size_t b = 0; b < count; b += Block) {
+		const size_t m = std::min(Block, count - b);
+		uniform(z, m, T(-1), T(1));
+		uniform(phi, m, T(0), T(2) * FastMathConstants<T>::pi);
+		fastSincos(phi, s, c, m);
+		for (size_t i = 0; i < m; i++) {
+			const T r  = std::sqrt(std::max(T(0), 1 - z[i] * z[i]));
+			res[b + i] = Vector<3, T>(r * c[i], r * s[i], z[i]);
+		}
+	}
+}
+
+template<typename T>
+void RandomBatch::inUnitBall(Vector<3, T> *res, size_t count) {
+	// direction times the cube root of a uniform radius for uniform density
+	constexpr size_t Block = 256;
+	T                u[Block];
+	onUnitSphere(res, count);
+	for (size_t b = 0; b < count; b += Block) {
+		const size_t m = std::min(Block, count - b);
+		uniform(u, m);
+		for (size_t i = 0; i < m; i++)
+			res[b + i] *= std::cbrt(u[i]);
+	}
+}
+
+RandomBatch::RandomBatch(uint64_t seed) {
+	Xoshiro256 source(seed);
+	*this = RandomBatch(source);
+}
+
+RandomBatch::RandomBatch(Xoshiro256 &source) {
+	for (size_t l = 0; l < Lanes; l++) {
+		for (size_t i = 0; i < 4; i++)
+			_state[i][l] = source.state()->s[i];
+		source.jump();
+	}
+}
+
+Xoshiro256 &threadRandom() {
+	thread_local Xoshiro256 res = Xoshiro256::Split();
+	return res;
+}
+
+template void RandomBatch::inBox<float>(
+	Vector<3, float> *,
+	size_t,
+	const Vector<3, float> &,
+	const Vector<3, float> &);
+template void RandomBatch::inBox<double>(
+	Vector<3, double> *,
+	size_t,
+	const Vector<3, double> &,
+	const Vector<3, double> &);
+template void RandomBatch::inUnitBall<float>(Vector<3, float> *, size_t);
+template void RandomBatch::inUnitBall<double>(Vector<3, double> *, size_t);
+template void RandomBatch::onUnitSphere<float>(Vector<3, float> *, size_t);
+template void RandomBatch::onUnitSphere<double>(Vector<3, double> *, size_t);
+
+} // namespace alp
+
+extern "C" {
+
+void rng_split(rng_t *rng) {
+	std::lock_guard<std::mutex> lock(alp::sequenceMutex);
+	if (!alp::sequenceSeeded) {
+		std::random_device dev;
+		rng_seed(&alp::sequence, (uint64_t(dev()) << 32) ^ dev());
+		alp::sequenceSeeded = true;
+	}
+	*rng = alp::sequence;
+	rng_jump(&alp::sequence);
+}
+
+rng_t *rng_thread(void) { return alp::threadRandom().state(); }
+
+void rng_fillFloat(rng_t *rng, float *res, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		res[i] = rng_float(rng);
+}
+void rng_fillDouble(rng_t *rng, double *res, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		res[i] = rng_double(rng);
+}
+}
@@ -0,0 +1,200 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_RANDOM_HPP
+#define ALPHA4_COMMON_RANDOM_HPP
+#include "alpha4/common/fastmath.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+extern "C" {
+#include "alpha4c/common/random.h"
+}
+
+namespace alp {
+
+// Distributions shared by the generators, which provide operator() returning
+// 64 random bits. Also satisfies UniformRandomBitGenerator for <random>.
+template<typename G> class RandomGenerator {
+	G &derived() { return static_cast<G &>(*this); }
+
+public:
+	typedef uint64_t result_type;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~result_type(0); }
+
+	// Uniform in [0, 1).
+	template<typename T = float> T uniform() {
+		if constexpr (std::is_same_v<T, float>)
+			return T(derived()() >> 40) * T(0x1p-24);
+		else
+			return T(derived()() >> 11) * T(0x1p-53);
+	}
+	template<typename T> T uniform(T lo, T hi) {
+		return lo + (hi - lo) * uniform<T>();
+	}
+
+	// Uniform in [0, n) without modulo bias (Lemire).
+	uint32_t uniformInt(uint32_t n) {
+		uint64_t m = (derived()() >> 32) * n;
+		if (uint32_t(m) < n) {
+			const uint32_t t = uint32_t(-n) % n;
+			while (uint32_t(m) < t)
+				m = (derived()() >> 32) * n;
+		}
+		return uint32_t(m >> 32);
+	}
+
+	template<typename T = float>
+	Vector<3, T> inBox(const Vector<3, T> &lo, const Vector<3, T> &hi) {
+		return Vector<3, T>(
+			uniform(lo.x(), hi.x()),
+			uniform(lo.y(), hi.y()),
+			uniform(lo.z(), hi.z()));
+	}
+	template<typename T = float> Vector<3, T> inUnitBall() {
+		Vector<3, T> res;
+		do {
+			res = Vector<3, T>(
+				2 * uniform<T>() - 1, 2 * uniform<T>() - 1, 2 * uniform<T>() - 1);
+		} while (res.square() > 1);
+		return res;
+	}
+	template<typename T = float> Vector<3, T> onUnitSphere() {
+		const T z = 2 * uniform<T>() - 1;
+		const T r = std::sqrt(std::max(T(0), 1 - z * z));
+		T       s, c;
+		fastSincos(T(2) * FastMathConstants<T>::pi * uniform<T>(), s, c);
+		return Vector<3, T>(r * c, r * s, z);
+	}
+};
+
+// xoshiro256++, sharing its state layout and algorithm with the C rng_t.
+class Xoshiro256 : public RandomGenerator<Xoshiro256> {
+protected:
+	rng_t _state;
+
+public:
+	explicit Xoshiro256(uint64_t seed) { rng_seed(&_state, seed); }
+	explicit Xoshiro256(const rng_t &state) : _state(state) {}
+
+	// A fresh substream of the process wide sequence, see rng_split().
+	static Xoshiro256 Split() {
+		rng_t state;
+		rng_split(&state);
+		return Xoshiro256(state);
+	}
+
+	uint64_t operator()() { return rng_next(&_state); }
+
+	// Advance by 2^128 and 2^192 steps, for non-overlapping parallel streams.
+	void jump() { rng_jump(&_state); }
+	void longJump() { rng_longJump(&_state); }
+
+	rng_t *      state() { return &_state; }
+	const rng_t *state() const { return &_state; }
+};
+
+// PCG XSL RR 128/64 (O'Neill). Seeds with distinct stream values give
+// independent sequences, advance() skips ahead in logarithmic time.
+class Pcg64 : public RandomGenerator<Pcg64> {
+public:
+	__extension__ typedef unsigned __int128 uint128;
+
+protected:
+	static constexpr const uint128 Multiplier =
+		(uint128(0x2360ed051fc65da4ull) << 64) | 0x4385df649fccf645ull;
+
+	uint128 _state = 0, _increment = 1;
+
+	void step() { _state = _state * Multiplier + _increment; }
+
+public:
+	explicit Pcg64(uint64_t seed, uint64_t stream = 0) {
+		_increment = (uint128(stream) << 1) | 1;
+		step();
+		_state += seed;
+		step();
+	}
+
+	uint64_t operator()() {
+		step();
+		const uint64_t x   = uint64_t(_state >> 64) ^ uint64_t(_state);
+		const unsigned rot = unsigned(_state >> 122);
+		return (x >> rot) | (x << ((64 - rot) & 63));
+	}
+
+	void advance(uint128 delta) {
+		uint128 mul = Multiplier, add = _increment;
+		uint128 accMul = 1, accAdd = 0;
+		for (; delta; delta >>= 1) {
+			if (delta & 1) {
+				accMul *= mul;
+				accAdd  = accAdd * mul + add;
+			}
+			add *= mul + 1;
+			mul *= mul;
+		}
+		_state = accMul * _state + accAdd;
+	}
+};
+
+// The calling thread's generator, also returned by rng_thread().
+Xoshiro256 &threadRandom();
+
+// Lanes independent xoshiro256++ streams advanced together on SIMD registers,
+// for bulk generation. Values are produced in blocks of one per lane, the
+// unused rest of a block is discarded.
+class RandomBatch {
+public:
+	static constexpr const size_t Lanes = 8;
+
+protected:
+	alignas(64) uint64_t _state[4][Lanes];
+
+public:
+	// Lane i starts i jumps into the stream of Xoshiro256(seed).
+	explicit RandomBatch(uint64_t seed);
+	// Lanes are taken from source by jumping, which leaves source past them.
+	explicit RandomBatch(Xoshiro256 &source);
+
+	void next(uint64_t *res, size_t count);
+	void uniform(float *res, size_t count);
+	void uniform(double *res, size_t count);
+	void uniform(float *res, size_t count, float lo, float hi);
+	void uniform(double *res, size_t count, double lo, double hi);
+
+	// Uniform in [0, n) by multiply and shift of 64 random bits, biased by at
+	// most 2^-32.
+	void uniformInt(uint32_t *res, size_t count, uint32_t n);
+
+	template<typename T>
+	void inBox(
+		Vector<3, T> *      res,
+		size_t              count,
+		const Vector<3, T> &lo,
+		const Vector<3, T> &hi);
+	template<typename T> void inUnitBall(Vector<3, T> *res, size_t count);
+	template<typename T> void onUnitSphere(Vector<3, T> *res, size_t count);
+};
+
+} // namespace alp
+#endif
@@ -0,0 +1,171 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_RECORDSCHEMA_HPP
+#define ALPHA4_COMMON_RECORDSCHEMA_HPP
+#include "alpha4/common/linescanner.hpp"
+#include "alpha4/common/parallelscanner.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace alp {
+
+template<typename M> struct MemberTraits;
+template<typename C, typename T> struct MemberTraits<T C::*> {
+	typedef C owner;
+	typedef T type;
+};
+
+// One token of a record, decoded into a data member, e.g. Field<&Point::x>.
+template<auto Member, LineScanner::ReadMode Mode = LineScanner::AnyString>
+struct Field {
+	typedef typename MemberTraits<decltype(Member)>::owner owner;
+	typedef typename MemberTraits<decltype(Member)>::type  type;
+
+	static constexpr const auto                  member = Member;
+	static constexpr const LineScanner::ReadMode mode   = Mode;
+};
+
+struct RecordError {
+	// 1-based line number and byte offset of the line
+	size_t line;
+	size_t offset;
+	// index of the first field that is missing or could not be decoded
+	size_t field;
+};
+
+// Fills in the line numbers of errors sorted by offset in data, counting
+// line breaks as records are split, see countLineEnds().
+inline void assignLineNumbers(
+	const char *data, std::vector<RecordError> &errors) {
+	size_t line = 1, pos = 0;
+	for (auto &e : errors) {
+		line   += countLineEnds(data + pos, data + e.offset);
+		pos     = e.offset;
+		e.line  = line;
+	}
+}
+
+// Fixed line format, declared once as a list of fields, e.g.
+//
+//   typedef RecordSchema<Item, Field<&Item::name>, Field<&Item::x>,
+//     Field<&Item::flags>> ItemSchema;
+//
+// decodeLine() reads the fields in order with LineScanner::get(), with types
+// and read modes resolved at compile time. Tokens after the last field are
+// ignored. The batch decoders parse a whole buffer in parallel, line by line,
+// into an array of structs or into one column per field, in input order.
+// Lines of blanks only are skipped like empty ones, lines that fail are
+// skipped and reported.
+template<typename Struct, typename... Fields> class RecordSchema {
+	static_assert(
+		(std::is_same_v<typename Fields::owner, Struct> && ...),
+		"fields must be members of the record");
+
+public:
+	static constexpr const size_t FieldCount = sizeof...(Fields);
+
+	typedef std::tuple<std::vector<typename Fields::type>...> Columns;
+
+	// Returns the number of fields decoded, FieldCount on success.
+	static size_t decodeLine(LineScanner &ln, Struct &rec) {
+		size_t n = 0;
+		(void)((ln.template get<typename Fields::type, Fields::mode>(
+							rec.*Fields::member)
+						&& ++n)
+					 && ...);
+		return n;
+	}
+
+	static std::vector<RecordError> decode(
+		const char *               data,
+		size_t                     size,
+		std::vector<Struct> &      out,
+		const ParallelScanOptions &options = ParallelScanOptions()) {
+		return decodeAll(data, size, options, [&out](Struct &&rec) {
+			out.push_back(std::move(rec));
+		});
+	}
+
+	static std::vector<RecordError> decode(
+		const char *               data,
+		size_t                     size,
+		Columns &                  out,
+		const ParallelScanOptions &options = ParallelScanOptions()) {
+		return decodeAll(data, size, options, [&out](Struct &&rec) {
+			appendColumns(out, rec, std::index_sequence_for<Fields...>());
+		});
+	}
+
+protected:
+	struct Decoded {
+		Struct rec;
+		size_t offset;
+		size_t fields;
+		bool   blank;
+	};
+
+	static bool isBlank(const LineScanner &ln) {
+		return std::all_of(
+			ln.data(), ln.data() + ln.size(), [](char c) { return c <= ' '; });
+	}
+
+	template<size_t... I>
+	static void
+		appendColumns(Columns &out, Struct &rec, std::index_sequence<I...>) {
+		(std::get<I>(out).push_back(std::move(rec.*Fields::member)), ...);
+	}
+
+	template<typename Append>
+	static std::vector<RecordError> decodeAll(
+		const char *        data,
+		size_t              size,
+		ParallelScanOptions options,
+		const Append &      append) {
+		std::vector<RecordError> errors;
+		options.ordered = true;
+
+		parallelScan(
+			data,
+			size,
+			[data](LineScanner &ln) {
+				Decoded res{Struct(), size_t(ln.data() - data), 0, isBlank(ln)};
+				if (!res.blank) res.fields = decodeLine(ln, res.rec);
+				return res;
+			},
+			[&](Decoded &&res) {
+				if (res.blank) return;
+				if (res.fields == FieldCount)
+					append(std::move(res.rec));
+				else
+					errors.push_back({0, res.offset, res.fields});
+			},
+			options);
+
+		// line numbers are only needed for failures, count them afterwards
+		assignLineNumbers(data, errors);
+		return errors;
+	}
+};
+
+} // namespace alp
+#endif
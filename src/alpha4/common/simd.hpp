@@ -0,0 +1,263 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_SIMD_HPP
+#define ALPHA4_COMMON_SIMD_HPP
+#include "alpha4/common/cpu.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Portable packs built on GCC/Clang vector extensions, 32 bytes wide by
+// default. Without AVX they are lowered to pairs of SSE (or NEON) registers.
+// Kernels written against them are force-inlined into functions compiled for a
+// specific target, so the packs never cross an ABI boundary. Only include this
+// from implementation files, as it silences the corresponding warning for the
+// whole translation unit.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define ALPHA4_SIMD_INLINE __attribute__((always_inline)) inline
+// for lambdas passed to kernels, which GCC may otherwise keep out of line
+#define ALPHA4_SIMD_LAMBDA __attribute__((always_inline))
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ALPHA4_SIMD_X86 1
+#define ALPHA4_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define ALPHA4_TARGET_AVX512                                                   \
+	__attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma")))
+#endif
+
+// Picks the variant of a kernel for activeIsa(). Kernels provide a
+// kernelGeneric function and, on x86, kernelAVX2 and kernelAVX512 variants
+// compiled with the targets above. Template arguments go into the second
+// parameter, e.g. ALPHA4_SIMD_SELECT(kernel, <T, N>).
+#ifdef ALPHA4_SIMD_X86
+#define ALPHA4_SIMD_SELECT(kernel, ...)                                        \
+	::alp::simd::select(                                                         \
+		kernel##Generic __VA_ARGS__,                                               \
+		kernel##AVX2 __VA_ARGS__,                                                  \
+		kernel##AVX512 __VA_ARGS__)
+#else
+#define ALPHA4_SIMD_SELECT(kernel, ...) kernel##Generic __VA_ARGS__
+#endif
+
+namespace alp {
+namespace simd {
+
+template<typename T, size_t B = 32> struct Pack {};
+template<size_t B> struct Pack<float, B> {
+	typedef float   type __attribute__((vector_size(B)));
+	typedef int32_t mask __attribute__((vector_size(B)));
+	typedef int32_t index __attribute__((vector_size(B)));
+};
+template<size_t B> struct Pack<double, B> {
+	typedef double  type __attribute__((vector_size(B)));
+	typedef int64_t mask __attribute__((vector_size(B)));
+	typedef int64_t index __attribute__((vector_size(B)));
+};
+
+template<typename T, size_t B = 32>
+constexpr const size_t Lanes = B / sizeof(T);
+
+// Pack width of the kernel variant for an instruction set, 64 bytes for
+// AVX-512 and 32 bytes otherwise.
+template<Isa I> constexpr const size_t PackBytes = I == Isa::AVX512 ? 64 : 32;
+
+// Callers hand kernels ranges that are a multiple of this, which every variant
+// can split into its own packs.
+template<typename T>
+constexpr const size_t MaxLanes = Lanes<T, PackBytes<Isa::AVX512>>;
+
+template<typename T, size_t B = 32> using pack_t = typename Pack<T, B>::type;
+template<typename T, size_t B = 32> using mask_t = typename Pack<T, B>::mask;
+
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B> load(const T *p) {
+	pack_t<T, B> res;
+	std::memcpy(&res, p, sizeof(res));
+	return res;
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE void store(T *p, const pack_t<T, B> &v) {
+	std::memcpy(p, &v, sizeof(v));
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B> broadcast(T v) {
+	return pack_t<T, B>{} + v;
+}
+
+// Strided gather, e.g. one component out of an array of structs.
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B> gather(const T *p, size_t stride) {
+	pack_t<T, B> res;
+	for (size_t i = 0; i < Lanes<T, B>; i++)
+		res[i] = p[i * stride];
+	return res;
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE void scatter(T *p, size_t stride, const pack_t<T, B> &v) {
+	for (size_t i = 0; i < Lanes<T, B>; i++)
+		p[i * stride] = v[i];
+}
+
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B> abs(const pack_t<T, B> &v) {
+	return v < 0 ? -v : v;
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B> sqrt(const pack_t<T, B> &v) {
+	pack_t<T, B> res;
+	for (size_t i = 0; i < Lanes<T, B>; i++)
+		res[i] = std::sqrt(v[i]);
+	return res;
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B>
+	min(const pack_t<T, B> &a, const pack_t<T, B> &b) {
+	return a < b ? a : b;
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE pack_t<T, B>
+	max(const pack_t<T, B> &a, const pack_t<T, B> &b) {
+	return a > b ? a : b;
+}
+template<typename T, size_t B = 32>
+ALPHA4_SIMD_INLINE bool any(const mask_t<T, B> &m) {
+	for (size_t i = 0; i < Lanes<T, B>; i++)
+		if (m[i]) return true;
+	return false;
+}
+
+// Byte vectors for text scanning. Comparisons follow the signedness of char,
+// so a classifier written as a generic lambda behaves the same on a vector and
+// on a single character.
+template<size_t W> struct Bytes {
+	typedef char type __attribute__((vector_size(W)));
+};
+template<size_t W> using bytes_t = typename Bytes<W>::type;
+
+// 16 byte vectors map to SSE2 or NEON, 32 byte vectors need AVX2 and 64 byte
+// vectors AVX-512.
+template<Isa I>
+constexpr const size_t ByteLanes =
+	I == Isa::Generic ? 16 : I == Isa::AVX2 ? 32 : 64;
+
+template<size_t W> ALPHA4_SIMD_INLINE bytes_t<W> loadBytes(const char *p) {
+	bytes_t<W> res;
+	std::memcpy(&res, p, W);
+	return res;
+}
+
+template<size_t W>
+using byte_mask_t = decltype(bytes_t<W>{} == bytes_t<W>{});
+
+// One bit per lane of a comparison result, lane 0 in the lowest bit. Only SSE2
+// is used on x86, as the kernels calling this are compiled for the default
+// target before being inlined into target specific variants.
+template<size_t W>
+ALPHA4_SIMD_INLINE uint64_t bitmask(const byte_mask_t<W> &m) {
+#ifdef ALPHA4_SIMD_X86
+	uint64_t res = 0;
+	for (size_t i = 0; i < W; i += 16) {
+		__m128i part;
+		std::memcpy(&part, reinterpret_cast<const char *>(&m) + i, 16);
+		res |= uint64_t(uint32_t(_mm_movemask_epi8(part))) << i;
+	}
+	return res;
+#else
+	uint64_t res = 0;
+	for (size_t i = 0; i < W; i++)
+		res |= uint64_t(m[i] != 0) << i;
+	return res;
+#endif
+}
+
+// Combine comparison results, on vectors as well as on single characters.
+// GCC scalarizes | and & on 64 byte masks in kernels compiled for the default
+// target, so vector masks are combined as 64 bit lanes. Lambdas calling these
+// need ALPHA4_SIMD_LAMBDA.
+template<typename M> ALPHA4_SIMD_INLINE M maskOr(const M &a, const M &b) {
+	if constexpr (std::is_arithmetic_v<M>)
+		return a | b;
+	else {
+		typedef uint64_t Q __attribute__((vector_size(sizeof(M))));
+		return M(Q(a) | Q(b));
+	}
+}
+template<typename M, typename... R>
+ALPHA4_SIMD_INLINE M maskOr(const M &a, const M &b, const R &...rest) {
+	return maskOr(maskOr(a, b), rest...);
+}
+template<typename M> ALPHA4_SIMD_INLINE M maskAnd(const M &a, const M &b) {
+	if constexpr (std::is_arithmetic_v<M>)
+		return a & b;
+	else {
+		typedef uint64_t Q __attribute__((vector_size(sizeof(M))));
+		return M(Q(a) & Q(b));
+	}
+}
+
+// Returns the first byte in [p, end) for which cls is true, or end. Classifies
+// 64 bytes per step and finishes the last partial vector one byte at a time.
+template<size_t W, typename Class>
+ALPHA4_SIMD_INLINE const char *
+	findByte(const char *p, const char *end, const Class &cls) {
+	constexpr size_t Step = 64;
+	for (; size_t(end - p) >= Step; p += Step) {
+		uint64_t bits = 0;
+		for (size_t i = 0; i < Step; i += W)
+			bits |= bitmask<W>(cls(loadBytes<W>(p + i))) << i;
+		if (bits) return p + __builtin_ctzll(bits);
+	}
+	for (; size_t(end - p) >= W; p += W) {
+		const uint64_t bits = bitmask<W>(cls(loadBytes<W>(p)));
+		if (bits) return p + __builtin_ctzll(bits);
+	}
+	for (; p < end; p++)
+		if (cls(*p)) return p;
+	return end;
+}
+
+// Number of bytes in [p, end) for which cls is true.
+template<size_t W, typename Class>
+ALPHA4_SIMD_INLINE size_t
+	countBytes(const char *p, const char *end, const Class &cls) {
+	size_t res = 0;
+	for (; size_t(end - p) >= W; p += W)
+		res += size_t(__builtin_popcountll(bitmask<W>(cls(loadBytes<W>(p)))));
+	for (; p < end; p++)
+		if (cls(*p)) res++;
+	return res;
+}
+
+template<typename F> inline F select(F generic, F avx2, F avx512) {
+	switch (activeIsa()) {
+		case Isa::AVX512: return avx512;
+		case Isa::AVX2: return avx2;
+		default: return generic;
+	}
+}
+
+} // namespace simd
+} // namespace alp
+#endif
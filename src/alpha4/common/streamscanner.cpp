@@ -0,0 +1,136 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "streamscanner.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace alp {
+
+StreamScanner::StreamScanner(Reader reader, size_t chunkSize, size_t ahead) :
+	_reader(std::move(reader)), _chunkSize(chunkSize ? chunkSize : ChunkSize) {
+	assign(nullptr, size_t(0));
+	_stableViews = false;
+	if (!ahead) return;
+	_free.resize(ahead);
+	_thread = std::thread(&StreamScanner::readAhead, this);
+}
+
+StreamScanner::StreamScanner(int fd, size_t chunkSize, size_t ahead) :
+	StreamScanner(
+		[fd](char *buf, size_t size) -> size_t {
+			for (;;) {
+				const ssize_t n = ::read(fd, buf, size);
+				if (n >= 0) return size_t(n);
+				if (errno != EINTR) return 0;
+			}
+		},
+		chunkSize,
+		ahead) {}
+
+StreamScanner::~StreamScanner() {
+	if (!_thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_cv.notify_all();
+	_thread.join();
+}
+
+void StreamScanner::readAhead() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	for (;;) {
+		_cv.wait(lock, [this] { return _stop || !_free.empty(); });
+		if (_stop) return;
+		std::vector<char> chunk = std::move(_free.back());
+		_free.pop_back();
+
+		lock.unlock();
+		chunk.resize(_chunkSize);
+		chunk.resize(_reader(chunk.data(), chunk.size()));
+		lock.lock();
+
+		const bool last = chunk.empty();
+		_full.push_back(std::move(chunk));
+		_cv.notify_all();
+		if (last) return;
+	}
+}
+
+bool StreamScanner::underflow(const char *&start) {
+	if (_done) return false;
+
+	// keep the line around start for getTrimmedLine(), which looks back to its
+	// beginning, but no more than a chunk, so memory does not grow with the
+	// length of lines
+	const char *keep  = start;
+	const char *limit = start - std::min(_chunkSize, size_t(start - _data));
+	while (keep > limit && keep[-1] != '\n' && keep[-1] != '\r')
+		keep--;
+
+	const size_t kept   = size_t(_end - keep);
+	const size_t pOff   = size_t(_p - keep);
+	const size_t sOff   = size_t(start - keep);
+	_offset            += size_t(keep - _data);
+	if (kept) std::memmove(_window.data(), keep, kept);
+
+	// the operation is repeated from start, so read at least as much as is kept
+	// to keep rescanning long lines linear
+	size_t added = 0;
+	while (!_done && (added == 0 || added < kept)) {
+		size_t n;
+		if (_thread.joinable()) {
+			std::vector<char> chunk;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_cv.wait(lock, [this] { return !_full.empty(); });
+				chunk = std::move(_full.front());
+				_full.pop_front();
+			}
+			n = chunk.size();
+			if (_window.size() < kept + added + n) _window.resize(kept + added + n);
+			if (n) std::memcpy(_window.data() + kept + added, chunk.data(), n);
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_free.push_back(std::move(chunk));
+			}
+			_cv.notify_all();
+		} else {
+			// without read-ahead the reader fills the window directly
+			if (_window.size() < kept + added + _chunkSize)
+				_window.resize(kept + added + _chunkSize);
+			n = _reader(_window.data() + kept + added, _chunkSize);
+		}
+		if (!n) _done = true;
+		added += n;
+	}
+
+	const bool moved = keep != _data || _window.data() != _data;
+
+	_data = _window.data();
+	_p    = _data + pOff;
+	start = _data + sOff;
+	_end  = _data + kept + added;
+	return moved || added;
+}
+
+} // namespace alp
@@ -0,0 +1,86 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_STREAMSCANNER_HPP
+#define ALPHA4_COMMON_STREAMSCANNER_HPP
+#include "alpha4/common/linescanner.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace alp {
+
+// LineScanner over input that arrives in chunks, e.g. from a pipe, socket or
+// stdin. Blanks and newlines are skipped across chunks, a token that runs into
+// the end of the buffered window is scanned again once the next chunk arrived,
+// so tokens and quoted strings spanning chunks are returned exactly as from
+// one contiguous buffer. Only the unfinished token is moved when refilling,
+// and memory is bounded by the chunk size times the read-ahead plus about
+// twice the longest token. Of the line before the position at most one chunk
+// is kept, which limits how far getTrimmedLine() looks back.
+// getTrimmedLine() and getLnRemainder() return the rest of a line as one view
+// and buffer all of it.
+//
+// With a read-ahead of at least one chunk, a reader thread fills chunks while
+// the caller parses. Views returned by getString() are only valid until the
+// next operation. seek() is limited to the current window.
+class StreamScanner : public LineScanner {
+public:
+	// Fills at most size bytes, returning 0 at the end of input.
+	typedef std::function<size_t(char *buf, size_t size)> Reader;
+
+	static constexpr const size_t ChunkSize = size_t(1) << 16;
+
+protected:
+	Reader            _reader;
+	size_t            _chunkSize;
+	std::vector<char> _window;
+	bool              _done = false;
+
+	// read-ahead, empty chunks signal the end of input
+	std::thread                    _thread;
+	std::mutex                     _mutex;
+	std::condition_variable        _cv;
+	std::deque<std::vector<char>>  _full;
+	std::vector<std::vector<char>> _free;
+	bool                           _stop = false;
+
+	void readAhead();
+	bool underflow(const char *&start) override;
+
+public:
+	StreamScanner(Reader reader, size_t chunkSize = ChunkSize, size_t ahead = 2);
+	// Reads from a descriptor the caller keeps ownership of.
+	StreamScanner(int fd, size_t chunkSize = ChunkSize, size_t ahead = 2);
+	// Waits for a pending read to return.
+	~StreamScanner();
+
+	StreamScanner(const StreamScanner &) = delete;
+	StreamScanner &operator=(const StreamScanner &) = delete;
+
+	// Bytes currently buffered, bounded as described above.
+	size_t windowCapacity() const { return _window.capacity(); }
+};
+
+} // namespace alp
+#endif
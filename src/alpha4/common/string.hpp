@@ -18,6 +18,9 @@ Alpha4. If not, see <https://www.gnu.org/licenses/>.
 #ifndef ALPHA_COMMON_STRING_HPP
 #define ALPHA_COMMON_STRING_HPP
 #include "alpha4/common/error.hpp"
+#include <charconv>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -28,16 +31,113 @@ namespace alp {
 template<typename T> struct StringTranscoder;
 
 // decode numbers
+//
+// Numbers are parsed within the bounds of the view and independently of the
+// locale. Like strtoll and strtold, leading whitespace is skipped, integers
+// take a 0x prefix for hexadecimal and a leading 0 for octal, floats a 0x
+// prefix for hexadecimal notation, and parsing stops at the first character
+// not belonging to the number.
+
+inline bool isNumberSpace(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+inline bool isHexDigit(char c) {
+	return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+// Splits an integer into sign and magnitude, false if there are no digits or
+// the magnitude overflows. stop receives the end of the number.
+inline bool decodeIntegerParts(
+	const std::string_view &s,
+	bool &                  negative,
+	unsigned long long &    magnitude,
+	const char *&           stop) {
+	const char *p = s.data(), *end = p + s.size();
+	while (p < end && isNumberSpace(*p))
+		p++;
+	negative = false;
+	if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+
+	int base = 10;
+	if (p < end && *p == '0') {
+		const bool hex = (end - p > 2) && ((p[1] | 0x20) == 'x')
+			&& isHexDigit(p[2]);
+		// without hex digits the leading zero is the number, as with strtoull
+		if (hex) {
+			base  = 16;
+			p    += 2;
+		} else
+			base = 8;
+	}
+	const auto res = std::from_chars(p, end, magnitude, base);
+	stop           = res.ptr;
+	return res.ec == std::errc() && res.ptr > p;
+}
+
+// Decodes [p, end) if it is a plain decimal, with a sign, digits and an
+// exponent, whose significand and power of ten are exactly representable in T.
+// A single multiplication or division then rounds correctly. Returns false
+// for anything else, which is left to from_chars.
+template<typename T>
+requires std::is_same_v<T, float> || std::is_same_v<T, double>
+bool decodeShortDecimal(const char *p, const char *end, T &v) {
+	constexpr int      MaxPower = std::is_same_v<T, float> ? 10 : 22;
+	constexpr uint64_t MaxSignificand = uint64_t(1)
+		<< std::numeric_limits<T>::digits;
+	static constexpr double Powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+																			1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+																			1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+																			1e18, 1e19, 1e20, 1e21, 1e22};
+
+	const bool negative = p < end && *p == '-';
+	p += negative;
+	uint64_t significand = 0;
+	int      digits = 0, power = 0;
+	for (; p < end && unsigned(*p - '0') < 10; p++, digits++) {
+		significand = significand * 10 + unsigned(*p - '0');
+		if (significand >= MaxSignificand) return false;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && unsigned(*p - '0') < 10; p++, digits++, power--) {
+			significand = significand * 10 + unsigned(*p - '0');
+			if (significand >= MaxSignificand) return false;
+		}
+	}
+	if (digits == 0) return false;
+	if (p < end && (*p | 0x20) == 'e') {
+		p++;
+		const bool negativeExponent = p < end && *p == '-';
+		p += p < end && (*p == '-' || *p == '+');
+		const char *first    = p;
+		int         exponent = 0;
+		for (; p < end && unsigned(*p - '0') < 10 && p - first < 4; p++)
+			exponent = exponent * 10 + (*p - '0');
+		if (p == first) return false;
+		power += negativeExponent ? -exponent : exponent;
+	}
+	if (p != end || power < -MaxPower || power > MaxPower) return false;
+
+	const T res = power < 0 ? T(significand) / T(Powers[-power])
+													: T(significand) * T(Powers[power]);
+	v = negative ? -res : res;
+	return true;
+}
+
 template<typename T>
 requires std::is_integral_v<T>
 	&&std::is_unsigned_v<T> struct StringTranscoder<T> {
 	bool operator()(const std::string_view &s, T &v) {
-		char *             endptr = nullptr;
-		unsigned long long vt     = strtoull(s.data(), &endptr, 0);
+		const char *stop;
+		return (*this)(s, v, stop);
+	}
+	bool operator()(const std::string_view &s, T &v, const char *&stop) {
+		bool               negative;
+		unsigned long long vt;
+		if (!decodeIntegerParts(s, negative, vt, stop)) return false;
 
-		if (endptr <= s.data()) return false;
+		if (vt > std::numeric_limits<T>::max()) return false;
+		if (negative && vt != 0) return false;
 		v = (T)(vt);
-		if ((unsigned long long)(v) != vt) return false;
 		return true;
 	}
 };
@@ -46,12 +146,17 @@ template<typename T>
 requires std::is_integral_v<T>
 	&&std::is_signed_v<T> struct StringTranscoder<T> {
 	bool operator()(const std::string_view &s, T &v) {
-		char *    endptr = nullptr;
-		long long vt     = strtoll(s.data(), &endptr, 0);
+		const char *stop;
+		return (*this)(s, v, stop);
+	}
+	bool operator()(const std::string_view &s, T &v, const char *&stop) {
+		bool               negative;
+		unsigned long long vt;
+		if (!decodeIntegerParts(s, negative, vt, stop)) return false;
 
-		if (endptr <= s.data()) return false;
-		v = (T)(vt);
-		if ((long long)(v) != vt) return false;
+		const unsigned long long limit = std::numeric_limits<T>::max();
+		if (vt > limit + (negative ? 1 : 0)) return false;
+		v = negative ? (T)(0ULL - vt) : (T)(vt);
 		return true;
 	}
 };
@@ -59,12 +164,50 @@ requires std::is_integral_v<T>
 template<typename T>
 requires std::is_floating_point_v<T> struct StringTranscoder<T> {
 	bool operator()(const std::string_view &s, T &v) {
-		char *      endptr = nullptr;
-		long double vt     = strtold(s.data(), &endptr);
+		const char *stop;
+		return (*this)(s, v, stop);
+	}
+	bool operator()(const std::string_view &s, T &v, const char *&stop) {
+		const char *p = s.data(), *end = p + s.size();
+		stop          = end;
+		if constexpr (!std::is_same_v<T, long double>)
+			if (decodeShortDecimal(p, end, v)) return true;
+		while (p < end && isNumberSpace(*p))
+			p++;
+		bool negative = false;
+		if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+		// from_chars would take a second minus sign
+		if (p < end && (*p == '+' || *p == '-')) return false;
 
-		if (endptr <= s.data()) return false;
-		v = (T)(vt);
-		// if ((long double)(v) != vt) return false;
+		// without hex digits after 0x only the 0 is parsed, as with strtold
+		std::chars_format format = std::chars_format::general;
+		if ((end - p > 2) && p[0] == '0' && ((p[1] | 0x20) == 'x')
+				&& (isHexDigit(p[2])
+						|| ((end - p > 3) && p[2] == '.' && isHexDigit(p[3])))) {
+			format  = std::chars_format::hex;
+			p      += 2;
+		}
+
+		T    vt;
+		auto res = std::from_chars(p, end, vt, format);
+		stop     = res.ptr;
+		if (res.ec == std::errc::result_out_of_range) {
+			// overflow to infinity and underflow to zero, as with strtold
+			long double lv;
+			if (std::from_chars(p, end, lv, format).ec == std::errc())
+				vt = (T)(lv);
+			else {
+				const char *exponent = format == std::chars_format::hex ? "pP" : "eE";
+				const std::string_view num(p, res.ptr - p);
+				const size_t           e    = num.find_last_of(exponent);
+				const bool             tiny = e != num.npos && e + 1 < num.size()
+					&& num[e + 1] == '-';
+				vt = tiny ? T(0) : std::numeric_limits<T>::infinity();
+			}
+			res.ec = std::errc();
+		}
+		if (res.ec != std::errc()) return false;
+		v = negative ? -vt : vt;
 		return true;
 	}
 };
@@ -112,6 +255,14 @@ template<typename T> bool decodeString(const std::string &str, T &v) {
 	return StringTranscoder<T>()(str, v);
 }
 
+// Like decodeString(), but fails unless the number ends with the view.
+template<typename T>
+requires std::is_arithmetic_v<T>
+bool decodeNumber(const std::string_view &str, T &v) {
+	const char *stop;
+	return StringTranscoder<T>()(str, v, stop) && stop == str.data() + str.size();
+}
+
 inline bool decodeString(const char *str, const char *&v) {
 	v = str;
 	return true;
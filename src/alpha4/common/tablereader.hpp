@@ -0,0 +1,285 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALPHA4_COMMON_TABLEREADER_HPP
+#define ALPHA4_COMMON_TABLEREADER_HPP
+#include "alpha4/common/mappedfile.hpp"
+#include "alpha4/common/parallelscanner.hpp"
+#include "alpha4/common/recordschema.hpp"
+#include "alpha4/common/string.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace alp {
+
+struct TableOptions {
+	// starts a comment, up to the end of the line
+	char comment = '#';
+	// lines to skip before the data, e.g. a header
+	size_t skipLines = 0;
+	// tokens standing for a missing value
+	std::vector<std::string> missing = {"NA"};
+	// approximate bytes per task
+	size_t      chunkSize = size_t(1) << 20;
+	ThreadPool *pool      = nullptr;
+};
+
+// Whitespace separated numeric table, one row per line, read into one array
+// per column, e.g. NumericTable<int, double, Vector<3, float>>. Vector columns
+// take one token per component. Blank lines and comments are skipped, fields
+// that are absent at the end of a line or given as a missing token get the
+// column's missing value, NaN or zero by default. Tokens after the last
+// column are ignored.
+//
+// read() counts line breaks to size the columns up front, then parses chunks
+// of the input in parallel straight into them. Rows with a field that cannot
+// be decoded are dropped and reported.
+template<typename... Columns> class NumericTable {
+	static_assert(sizeof...(Columns) > 0, "tables need a column");
+
+	template<typename C> struct ColumnTraits {
+		typedef VectorTraits<C> Traits;
+		static constexpr const size_t Components = Traits::Dimensions();
+
+		template<typename V> static auto &component(V &v, size_t i) {
+			if constexpr (Traits::IsVector)
+				return v[i];
+			else {
+				(void)i;
+				return v;
+			}
+		}
+		typedef std::remove_reference_t<decltype(component(
+			std::declval<C &>(), 0))>
+			Scalar;
+		static_assert(std::is_arithmetic_v<Scalar>, "columns must be numeric");
+
+		static C missing() {
+			C res{};
+			for (size_t i = 0; i < Components; i++)
+				component(res, i) = std::numeric_limits<Scalar>::has_quiet_NaN
+					? std::numeric_limits<Scalar>::quiet_NaN()
+					: Scalar(0);
+			return res;
+		}
+	};
+
+public:
+	static constexpr const size_t ColumnCount = sizeof...(Columns);
+
+	typedef std::tuple<std::vector<Columns>...> Storage;
+
+	Storage                  columns;
+	std::tuple<Columns...>   missing{ColumnTraits<Columns>::missing()...};
+	std::vector<RecordError> errors;
+
+	size_t rows() const { return std::get<0>(columns).size(); }
+
+	template<size_t I> auto &column() { return std::get<I>(columns); }
+	template<size_t I> const auto &column() const {
+		return std::get<I>(columns);
+	}
+
+	// Replaces the contents with the rows of [data, data + size). Returns false
+	// if rows were dropped, see errors.
+	bool read(
+		const char *data, size_t size, const TableOptions &options = {}) {
+		errors.clear();
+		resize(0, std::index_sequence_for<Columns...>());
+		const char *end   = data + size;
+		const char *begin = data;
+		for (size_t i = 0; i < options.skipLines && begin < end; i++) {
+			begin = findRecordEnd(begin, end, ParallelScanOptions());
+			if (begin < end && *begin == '\r') begin++;
+			if (begin < end && *begin == '\n') begin++;
+		}
+
+		ParallelScanOptions split;
+		split.chunkSize  = options.chunkSize;
+		split.pool       = options.pool;
+		ThreadPool &pool = options.pool ? *options.pool : ThreadPool::Global();
+		const std::vector<size_t> chunks =
+			splitRecords(begin, size_t(end - begin), split);
+		const size_t count = chunks.size() - 1;
+
+		// every chunk gets a row slot per line, rows end up compacted in order
+		std::vector<size_t> slots(count + 1, 0);
+		pool.parallelFor(0, count, 1, [&](size_t b, size_t e) {
+			for (size_t c = b; c < e; c++)
+				slots[c + 1] =
+					countLineBreaks(begin + chunks[c], begin + chunks[c + 1]) + 1;
+		});
+		for (size_t c = 0; c < count; c++)
+			slots[c + 1] += slots[c];
+		resize(slots[count], std::index_sequence_for<Columns...>());
+
+		std::vector<size_t>                   produced(count, 0);
+		std::vector<std::vector<RecordError>> failed(count);
+		pool.parallelFor(0, count, 1, [&](size_t b, size_t e) {
+			for (size_t c = b; c < e; c++)
+				produced[c] = parseChunk(
+					begin + chunks[c],
+					begin + chunks[c + 1],
+					slots[c],
+					data,
+					options,
+					failed[c]);
+		});
+
+		size_t rows = 0;
+		for (size_t c = 0; c < count; c++) {
+			compact(
+				slots[c], rows, produced[c], std::index_sequence_for<Columns...>());
+			rows += produced[c];
+			errors.insert(errors.end(), failed[c].begin(), failed[c].end());
+		}
+		resize(rows, std::index_sequence_for<Columns...>());
+
+		assignLineNumbers(data, errors);
+		return errors.empty();
+	}
+
+	// Reads a whole file, see MappedFile. Returns false with errno set if it
+	// cannot be opened, or if rows were dropped.
+	bool load(const char *path, const TableOptions &options = {}) {
+		MappedFile file;
+		if (!file.open(path)) return false;
+		return read(file.data(), file.size(), options);
+	}
+
+protected:
+	template<size_t... I>
+	void resize(size_t rows, std::index_sequence<I...>) {
+		(std::get<I>(columns).resize(rows), ...);
+	}
+
+	template<size_t... I>
+	void compact(size_t from, size_t to, size_t n, std::index_sequence<I...>) {
+		if (from == to) return;
+		auto move = [&](auto &col) {
+			std::move(col.begin() + from, col.begin() + from + n, col.begin() + to);
+		};
+		(move(std::get<I>(columns)), ...);
+	}
+
+	static bool isMissing(
+		const char *p, const char *e, const TableOptions &options) {
+		const std::string_view token(p, size_t(e - p));
+		for (auto &m : options.missing)
+			if (token == m) return true;
+		return false;
+	}
+
+	// Plain decimal tokens take the fast path, anything else must be a whole
+	// number as decodeString() reads it, see decodeNumber().
+	template<typename T>
+	static bool decodeField(const char *p, const char *e, T &v) {
+		if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>)
+			if (decodeShortDecimal(p, e, v)) return true;
+		const auto res = std::from_chars(p, e, v);
+		if (res.ptr == e && res.ec == std::errc()) return true;
+		return decodeNumber(std::string_view(p, size_t(e - p)), v);
+	}
+
+	// Decodes the fields of column I into row, advancing p. Returns false if a
+	// token cannot be decoded.
+	template<size_t I>
+	bool parseColumn(
+		const char *&       p,
+		const char *        end,
+		size_t              row,
+		const TableOptions &options) {
+		typedef ColumnTraits<std::tuple_element_t<I, std::tuple<Columns...>>> CT;
+		auto &value = std::get<I>(columns)[row];
+		for (size_t i = 0; i < CT::Components; i++) {
+			auto &dst = CT::component(value, i);
+			while (p < end && *p <= ' ')
+				p++;
+			if (p == end || *p == options.comment) {
+				dst = CT::component(std::get<I>(missing), i);
+				continue;
+			}
+			const char *token = p;
+			while (p < end && *p > ' ')
+				p++;
+			if (isMissing(token, p, options))
+				dst = CT::component(std::get<I>(missing), i);
+			else if (!decodeField(token, p, dst))
+				return false;
+		}
+		return true;
+	}
+
+	template<size_t... I>
+	size_t parseRow(
+		const char *        p,
+		const char *        end,
+		size_t              row,
+		const TableOptions &options,
+		std::index_sequence<I...>) {
+		size_t n = 0;
+		(void)((parseColumn<I>(p, end, row, options) && ++n) && ...);
+		return n;
+	}
+
+	// Parses the lines of [p, end) into consecutive rows from row on, returns
+	// their number.
+	size_t parseChunk(
+		const char *              p,
+		const char *              end,
+		size_t                    row,
+		const char *              data,
+		const TableOptions &      options,
+		std::vector<RecordError> &failed) {
+		const size_t first = row;
+		while (p < end) {
+			if (*p == '\n' || *p == '\r') {
+				p++;
+				continue;
+			}
+			const char *e = findRecordEnd(p, end, ParallelScanOptions());
+			const char *q = p;
+			while (q < e && *q <= ' ')
+				q++;
+			if (q < e && *q != options.comment) {
+				const size_t n = parseRow(
+					q, e, row, options, std::index_sequence_for<Columns...>());
+				if (n == ColumnCount)
+					row++;
+				else
+					failed.push_back({0, size_t(p - data), n});
+			}
+			p = e;
+		}
+		return row - first;
+	}
+};
+
+} // namespace alp
+#endif
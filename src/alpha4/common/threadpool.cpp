@@ -0,0 +1,182 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "threadpool.hpp"
+
+#include <cstdint>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace alp {
+namespace {
+
+thread_local const ThreadPool *currentPool  = nullptr;
+thread_local size_t            currentIndex = 0;
+thread_local uint32_t          victimSeed   = 0;
+
+// Rounds of failed stealing before an idle worker goes to sleep.
+constexpr const unsigned SpinRounds = 64;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t workers, bool pin) :
+	_workerCount(workers), _queues(new Queue[workers + 1]) {
+	_workers.reserve(workers);
+	for (size_t i = 0; i < workers; i++)
+		_workers.emplace_back([this, i, pin]() { workerLoop(i, pin); });
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for (auto &t : _workers)
+		t.join();
+}
+
+size_t ThreadPool::DefaultWorkers() {
+	const size_t hw = std::thread::hardware_concurrency();
+	return hw > 1 ? hw - 1 : 0;
+}
+
+ThreadPool &ThreadPool::Global() {
+	static ThreadPool pool;
+	return pool;
+}
+
+size_t ThreadPool::currentWorker() const {
+	return currentPool == this ? currentIndex : _workerCount;
+}
+
+void ThreadPool::push(const Task &task) {
+	Queue &q = _queues[currentWorker()];
+	{
+		std::lock_guard<std::mutex> lock(q.mutex);
+		q.tasks.push_back(task);
+	}
+	_queued.fetch_add(1);
+	if (_sleeping.load() > 0) {
+		// pairs with the check under the lock in workerLoop()
+		{ std::lock_guard<std::mutex> lock(_sleepMutex); }
+		_wake.notify_one();
+	}
+}
+
+bool ThreadPool::acquire(Task &task) {
+	if (_queued.load(std::memory_order_relaxed) == 0) return false;
+
+	const size_t n    = _workerCount + 1;
+	const size_t self = currentWorker();
+	{
+		Queue &                     q = _queues[self];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.tasks.empty()) {
+			task = q.tasks.back();
+			q.tasks.pop_back();
+			_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// steal, starting at a random victim
+	victimSeed         = victimSeed * 1664525u + 1013904223u;
+	const size_t start = (uint64_t(victimSeed >> 8) * n) >> 24;
+	for (size_t k = 0; k < n; k++) {
+		const size_t v = (start + k) % n;
+		if (v == self) continue;
+		// busy queues are skipped, their owner is working on them
+		Queue &                      q = _queues[v];
+		std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+		if (lock.owns_lock() && !q.tasks.empty()) {
+			task = q.tasks.front();
+			q.tasks.pop_front();
+			_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::execute(const Task &task) {
+	task.invoke(task);
+	if (task.group) task.group->finish();
+}
+
+void ThreadPool::notifyGroups() {
+	{ std::lock_guard<std::mutex> lock(_sleepMutex); }
+	_groupDone.notify_all();
+}
+
+void ThreadPool::workerLoop(size_t index, bool pin) {
+	currentPool  = this;
+	currentIndex = index;
+	victimSeed   = uint32_t(index * 2654435761u + 1);
+
+#ifdef __linux__
+	if (pin) {
+		const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+		cpu_set_t      set;
+		CPU_ZERO(&set);
+		CPU_SET((index + 1) % hw, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#else
+	(void)pin;
+#endif
+
+	Task     task;
+	unsigned idle = 0;
+	while (!_stop.load(std::memory_order_relaxed)) {
+		if (acquire(task)) {
+			execute(task);
+			idle = 0;
+		} else if (++idle < SpinRounds) {
+			std::this_thread::yield();
+		} else {
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_sleeping.fetch_add(1);
+			_wake.wait(lock, [this]() { return _queued.load() > 0 || _stop; });
+			_sleeping.fetch_sub(1);
+			idle = 0;
+		}
+	}
+}
+
+void TaskGroup::wait() {
+	ThreadPool::Task task;
+	unsigned         idle = 0;
+	while (!done()) {
+		if (_pool.acquire(task)) {
+			_pool.execute(task);
+			idle = 0;
+		} else if (++idle < SpinRounds) {
+			std::this_thread::yield();
+		} else {
+			// the remaining tasks are running, block until they finish
+			std::unique_lock<std::mutex> lock(_pool._sleepMutex);
+			_pool._groupDone.wait(lock, [this]() { return done(); });
+		}
+	}
+}
+
+} // namespace alp
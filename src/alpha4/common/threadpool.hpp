@@ -0,0 +1,235 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_COMMON_THREADPOOL_HPP
+#define ALPHA4_COMMON_THREADPOOL_HPP
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace alp {
+
+class TaskGroup;
+
+// Work-stealing thread pool. Every worker owns a deque: it pushes and pops its
+// own tasks at the back, idle workers steal from the front of the others.
+// Tasks submitted from outside the pool go to a shared deque. A thread waiting
+// on a TaskGroup executes queued tasks until the group is done, so waiting from
+// within a task does not block a worker, and a pool without workers runs
+// everything on the waiting thread.
+//
+// Tasks must not throw.
+class ThreadPool {
+	friend class TaskGroup;
+
+public:
+	struct Task {
+		void (*invoke)(const Task &);
+		const void *data;
+		size_t      begin, end;
+		TaskGroup * group;
+	};
+
+protected:
+	struct alignas(64) Queue {
+		std::mutex       mutex;
+		std::deque<Task> tasks;
+	};
+
+	const size_t             _workerCount;
+	std::vector<std::thread> _workers;
+	// one queue per worker, followed by the shared one
+	std::unique_ptr<Queue[]> _queues;
+	std::atomic<size_t>      _queued{0};
+	std::atomic<size_t>      _sleeping{0};
+	std::atomic<bool>        _stop{false};
+	std::mutex               _sleepMutex;
+	std::condition_variable  _wake, _groupDone;
+
+	void push(const Task &task);
+	bool acquire(Task &task);
+	void execute(const Task &task);
+	void workerLoop(size_t index, bool pin);
+
+	template<typename F> struct RangeJob {
+		const F *fn;
+		size_t   grain;
+	};
+
+	// Halves the range, queueing the upper half, while both halves are at least
+	// grain large, then runs what is left. Thieves take the oldest, i.e.
+	// largest, halves first.
+	template<typename F> static void runRange(const Task &task);
+
+	void notifyGroups();
+
+public:
+	// Starts worker threads, by default one less than the hardware threads, as
+	// the thread waiting for results takes part in the work. With pin set,
+	// worker i is bound to core i + 1 where supported.
+	explicit ThreadPool(size_t workers = DefaultWorkers(), bool pin = false);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	static size_t DefaultWorkers();
+
+	// Process wide pool used by parallelFor() and the batch kernels.
+	static ThreadPool &Global();
+
+	size_t workers() const { return _workerCount; }
+	// Threads working on a parallelFor(), including the calling one.
+	size_t concurrency() const { return _workerCount + 1; }
+
+	// Index of the calling worker within this pool, or workers() for threads
+	// outside of it.
+	size_t currentWorker() const;
+
+	// Calls fn(chunkBegin, chunkEnd) on disjoint chunks covering [begin, end)
+	// and returns once all of them are done. Chunks are at least grain and less
+	// than 2 * grain items large, unless the whole range is smaller, and a
+	// range is split into no more than about 8 chunks per thread.
+	template<typename F>
+	void parallelFor(size_t begin, size_t end, size_t grain, const F &fn);
+
+	// Reduces map(chunkBegin, chunkEnd) over chunks of grain items with
+	// reduce(a, b), starting from init. Chunks are combined in order, so the
+	// result does not depend on the number of threads.
+	template<typename T, typename Map, typename Reduce>
+	T parallelReduce(
+		size_t        begin,
+		size_t        end,
+		size_t        grain,
+		T             init,
+		const Map &   map,
+		const Reduce &reduce);
+};
+
+// Set of tasks that can be waited for together. The destructor waits as well.
+class TaskGroup {
+	friend class ThreadPool;
+
+	ThreadPool &        _pool;
+	std::atomic<size_t> _pending{0};
+
+	void finish() {
+		// the group may be gone as soon as the count drops to zero
+		ThreadPool &pool = _pool;
+		if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			pool.notifyGroups();
+	}
+
+	template<typename F> static void invokeOwned(const ThreadPool::Task &task) {
+		std::unique_ptr<F> fn(static_cast<F *>(const_cast<void *>(task.data)));
+		(*fn)();
+	}
+
+public:
+	explicit TaskGroup(ThreadPool &pool = ThreadPool::Global()) : _pool(pool) {}
+	~TaskGroup() { wait(); }
+
+	TaskGroup(const TaskGroup &) = delete;
+	TaskGroup &operator=(const TaskGroup &) = delete;
+
+	ThreadPool &pool() const { return _pool; }
+
+	// Queues fn() for execution by the pool.
+	template<typename F> void run(F &&fn) {
+		typedef std::decay_t<F> Fn;
+		add({invokeOwned<Fn>, new Fn(std::forward<F>(fn)), 0, 0, this});
+	}
+
+	// Queues a task whose data stays owned by the caller.
+	void add(const ThreadPool::Task &task) {
+		_pending.fetch_add(1, std::memory_order_relaxed);
+		ThreadPool::Task t = task;
+		t.group            = this;
+		_pool.push(t);
+	}
+
+	bool done() const { return _pending.load(std::memory_order_acquire) == 0; }
+
+	// Executes queued tasks of any group until all tasks of this one are done.
+	void wait();
+};
+
+template<typename F> void ThreadPool::runRange(const Task &task) {
+	const RangeJob<F> &job = *static_cast<const RangeJob<F> *>(task.data);
+
+	size_t b = task.begin, e = task.end;
+	while (e - b >= 2 * job.grain) {
+		const size_t mid = b + (e - b) / 2;
+		task.group->add({runRange<F>, task.data, mid, e, nullptr});
+		e = mid;
+	}
+	(*job.fn)(b, e);
+}
+
+template<typename F>
+void ThreadPool::parallelFor(
+	size_t begin, size_t end, size_t grain, const F &fn) {
+	if (end <= begin) return;
+
+	const size_t n = end - begin;
+	grain          = std::max({grain, size_t(1), n / (8 * concurrency())});
+	if (n < 2 * grain || _workerCount == 0) {
+		fn(begin, end);
+		return;
+	}
+
+	const RangeJob<F> job{&fn, grain};
+	TaskGroup         group(*this);
+	group._pending.fetch_add(1, std::memory_order_relaxed);
+	execute({runRange<F>, &job, begin, end, &group});
+	group.wait();
+}
+
+template<typename T, typename Map, typename Reduce>
+T ThreadPool::parallelReduce(
+	size_t        begin,
+	size_t        end,
+	size_t        grain,
+	T             init,
+	const Map &   map,
+	const Reduce &reduce) {
+	if (end <= begin) return init;
+	grain = std::max<size_t>(grain, 1);
+
+	const size_t   chunks = (end - begin + grain - 1) / grain;
+	std::vector<T> partial(chunks, init);
+	parallelFor(0, chunks, 1, [&](size_t b, size_t e) {
+		for (size_t c = b; c < e; c++) {
+			const size_t cb = begin + c * grain;
+			partial[c]      = map(cb, std::min(end, cb + grain));
+		}
+	});
+	for (size_t c = 0; c < chunks; c++)
+		init = reduce(init, partial[c]);
+	return init;
+}
+
+} // namespace alp
+#endif
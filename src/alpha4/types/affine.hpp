@@ -0,0 +1,166 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_AFFINE_HPP
+#define ALPHA4_TYPES_AFFINE_HPP
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <iostream>
+
+namespace alp {
+
+// Affine transformation as the upper 3x4 block of a Matrix4, stored row-major.
+// The implicit last row is (0, 0, 0, 1).
+template<typename T> struct Affine3 {
+	// clang-format off
+	T a11, a12, a13, a14,
+	  a21, a22, a23, a24,
+	  a31, a32, a33, a34;
+	// clang-format on
+
+	Affine3() :
+		// clang-format off
+		a11(1), a12(0), a13(0), a14(0),
+		a21(0), a22(1), a23(0), a24(0),
+		a31(0), a32(0), a33(1), a34(0) { }
+	// clang-format on
+
+	Affine3(
+		// clang-format off
+		T a, T b, T c, T d,
+		T e, T f, T g, T h,
+		T i, T j, T k, T l) :
+		a11(a), a12(b), a13(c), a14(d),
+		a21(e), a22(f), a23(g), a24(h),
+		a31(i), a32(j), a33(k), a34(l) { }
+	// clang-format on
+
+	// Drops the projective row of m.
+	template<matrix_storage_type_t stor>
+	static Affine3 FromMatrix(const Matrix4<T, stor> &m) {
+		// clang-format off
+		return Affine3(
+			m.a11, m.a12, m.a13, m.a14,
+			m.a21, m.a22, m.a23, m.a24,
+			m.a31, m.a32, m.a33, m.a34);
+		// clang-format on
+	}
+
+	template<matrix_storage_type_t stor = ROW_MAJOR>
+	Matrix4<T, stor> toMatrix() const {
+		// clang-format off
+		return Matrix4<T, stor>(
+			a11, a12, a13, a14,
+			a21, a22, a23, a24,
+			a31, a32, a33, a34,
+			0,   0,   0,   1);
+		// clang-format on
+	}
+
+	static Affine3 Translation(const Vector<3, T> &v) {
+		// clang-format off
+		return Affine3(
+			1, 0, 0, v.x(),
+			0, 1, 0, v.y(),
+			0, 0, 1, v.z());
+		// clang-format on
+	}
+
+	Vector<3, T> translation() const { return {a14, a24, a34}; }
+
+	// transforms a point, (x,y,z,1)
+	Vector<3, T> operator*(const Vector<3, T> &v) const {
+		// clang-format off
+		return {
+			a11*v.x() + a12*v.y() + a13*v.z() + a14,
+			a21*v.x() + a22*v.y() + a23*v.z() + a24,
+			a31*v.x() + a32*v.y() + a33*v.z() + a34};
+		// clang-format on
+	}
+
+	// transforms a direction, (x,y,z,0)
+	Vector<3, T> rotate(const Vector<3, T> &v) const {
+		// clang-format off
+		return {
+			a11*v.x() + a12*v.y() + a13*v.z(),
+			a21*v.x() + a22*v.y() + a23*v.z(),
+			a31*v.x() + a32*v.y() + a33*v.z()};
+		// clang-format on
+	}
+
+	Affine3 operator*(const Affine3 &m) const {
+		// clang-format off
+		return Affine3(
+			a11*m.a11 + a12*m.a21 + a13*m.a31,
+			a11*m.a12 + a12*m.a22 + a13*m.a32,
+			a11*m.a13 + a12*m.a23 + a13*m.a33,
+			a11*m.a14 + a12*m.a24 + a13*m.a34 + a14,
+
+			a21*m.a11 + a22*m.a21 + a23*m.a31,
+			a21*m.a12 + a22*m.a22 + a23*m.a32,
+			a21*m.a13 + a22*m.a23 + a23*m.a33,
+			a21*m.a14 + a22*m.a24 + a23*m.a34 + a24,
+
+			a31*m.a11 + a32*m.a21 + a33*m.a31,
+			a31*m.a12 + a32*m.a22 + a33*m.a32,
+			a31*m.a13 + a32*m.a23 + a33*m.a33,
+			a31*m.a14 + a32*m.a24 + a33*m.a34 + a34);
+		// clang-format on
+	}
+
+	T det() const {
+		return a11 * (a22 * a33 - a23 * a32) - a12 * (a21 * a33 - a23 * a31)
+			+ a13 * (a21 * a32 - a22 * a31);
+	}
+
+	Affine3 inverse() const {
+		T d = det();
+		// same convention as Matrix4::inverse
+		d = (d == 0) ? T(1) : T(1) / d;
+
+		Affine3 r(
+			// clang-format off
+			d*(a22*a33 - a23*a32), d*(a13*a32 - a12*a33), d*(a12*a23 - a13*a22), 0,
+			d*(a23*a31 - a21*a33), d*(a11*a33 - a13*a31), d*(a13*a21 - a11*a23), 0,
+			d*(a21*a32 - a22*a31), d*(a12*a31 - a11*a32), d*(a11*a22 - a12*a21), 0);
+		// clang-format on
+		const Vector<3, T> t = r.rotate(translation());
+		r.a14                = -t.x();
+		r.a24                = -t.y();
+		r.a34                = -t.z();
+		return r;
+	}
+
+	friend std::ostream &operator<<(std::ostream &o, const Affine3 &m) {
+		// clang-format off
+		return o
+			<< m.a11 << " " << m.a12 << " " << m.a13 << " " << m.a14 << std::endl
+			<< m.a21 << " " << m.a22 << " " << m.a23 << " " << m.a24 << std::endl
+			<< m.a31 << " " << m.a32 << " " << m.a33 << " " << m.a34 << std::endl;
+		// clang-format on
+	}
+};
+
+typedef Affine3<float>  aff3f;
+typedef Affine3<double> aff3d;
+
+} // namespace alp
+
+extern template struct alp::Affine3<float>;
+extern template struct alp::Affine3<double>;
+#endif
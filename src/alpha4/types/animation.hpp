@@ -0,0 +1,339 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_ANIMATION_HPP
+#define ALPHA4_TYPES_ANIMATION_HPP
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/types/affine.hpp"
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/quaternion.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace alp {
+
+enum class Interpolation : uint8_t { Step, Linear, Cubic };
+enum class AnimationChannel : uint8_t { Translation, Rotation, Scale };
+
+// Keyframed translation, rotation and scale tracks of a set of targets, e.g.
+// the nodes of a TransformHierarchy.
+//
+// Key times and values of all tracks live in two flat arrays, per track data
+// in parallel arrays indexed by the track handle. Every track remembers the
+// key used by its last evaluation, so sampling at monotonically increasing
+// times finds the next key without a search. Cubic tracks interpolate with
+// Catmull-Rom tangents derived from the neighbouring keys. Rotations are
+// slerped when linear, and renormalized when cubic.
+template<typename T> class AnimationClip {
+public:
+	typedef size_t Target;
+	typedef size_t Track;
+
+	static constexpr const Track  None  = Track(-1);
+	static constexpr const size_t Grain = 256;
+
+protected:
+	std::vector<T> _times;
+	std::vector<T> _values;
+
+	// per track
+	std::vector<size_t>           _keyBegin;
+	std::vector<size_t>           _keyCount;
+	std::vector<size_t>           _valueBegin;
+	std::vector<size_t>           _cursor;
+	std::vector<Interpolation>    _interpolation;
+	std::vector<AnimationChannel> _channel;
+
+	// per target, indexed by channel
+	std::vector<std::array<Track, 3>> _targets;
+
+	T _start = 0, _end = 0;
+
+	static size_t components(AnimationChannel channel) {
+		return channel == AnimationChannel::Rotation ? 4 : 3;
+	}
+
+	// Index of the key starting the interval that contains time, which has to
+	// lie strictly inside the key range of the track.
+	size_t findKey(Track k, T time) {
+		const T *    t = _times.data() + _keyBegin[k];
+		const size_t n = _keyCount[k];
+		size_t &     c = _cursor[k];
+		if (c + 1 < n && t[c] <= time) {
+			if (time < t[c + 1]) return c;
+			if (c + 2 < n && time < t[c + 2]) return ++c;
+		}
+		c = size_t(std::upper_bound(t, t + n, time) - t) - 1;
+		return c;
+	}
+
+	void evaluate(Track k, T time, T *res) {
+		const T *    t = _times.data() + _keyBegin[k];
+		const T *    v = _values.data() + _valueBegin[k];
+		const size_t n = _keyCount[k];
+		const size_t d = components(_channel[k]);
+
+		if (n == 1 || !(time > t[0])) {
+			std::copy(v, v + d, res);
+			return;
+		}
+		if (!(time < t[n - 1])) {
+			std::copy(v + (n - 1) * d, v + n * d, res);
+			return;
+		}
+
+		const size_t i     = findKey(k, time);
+		const bool   isRot = _channel[k] == AnimationChannel::Rotation;
+		const T      h     = t[i + 1] - t[i];
+		const T      u     = (time - t[i]) / h;
+
+		switch (_interpolation[k]) {
+			case Interpolation::Step:
+				std::copy(v + i * d, v + (i + 1) * d, res);
+				return;
+
+			case Interpolation::Linear:
+				if (isRot) {
+					const Quaternion<T> q = Quaternion<T>::Slerp(
+						rotationAt(v, i), rotationAt(v, i + 1), u);
+					std::copy(q.begin(), q.end(), res);
+				} else {
+					for (size_t c = 0; c < d; c++)
+						res[c] = v[i * d + c] + (v[(i + 1) * d + c] - v[i * d + c]) * u;
+				}
+				return;
+
+			case Interpolation::Cubic: {
+				// keys i - 1 .. i + 2, repeating the end keys at the boundaries
+				const size_t j[4] = {
+					i > 0 ? i - 1 : i, i, i + 1, i + 2 < n ? i + 2 : i + 1};
+				T            p[4][4];
+				for (size_t a = 0; a < 4; a++) {
+					std::copy(v + j[a] * d, v + (j[a] + 1) * d, p[a]);
+					if (isRot && a > 0) {
+						// keep neighbours in the same hemisphere
+						T dot = 0;
+						for (size_t c = 0; c < d; c++)
+							dot += p[a][c] * p[a - 1][c];
+						if (dot < 0) {
+							for (size_t c = 0; c < d; c++)
+								p[a][c] = -p[a][c];
+						}
+					}
+				}
+				const T u2 = u * u, u3 = u2 * u;
+				const T h00 = 2 * u3 - 3 * u2 + 1, h10 = u3 - 2 * u2 + u;
+				const T h01 = 3 * u2 - 2 * u3, h11 = u3 - u2;
+				const T s1 = h / (t[j[2]] - t[j[0]]), s2 = h / (t[j[3]] - t[j[1]]);
+
+				T len = 0;
+				for (size_t c = 0; c < d; c++) {
+					const T m1 = (p[2][c] - p[0][c]) * s1;
+					const T m2 = (p[3][c] - p[1][c]) * s2;
+					res[c]     = h00 * p[1][c] + h10 * m1 + h01 * p[2][c] + h11 * m2;
+					len       += res[c] * res[c];
+				}
+				if (isRot) {
+					len = T(1) / std::sqrt(len);
+					for (size_t c = 0; c < d; c++)
+						res[c] *= len;
+				}
+				return;
+		}
+		}
+	}
+
+	static Quaternion<T> rotationAt(const T *v, size_t i) {
+		return Quaternion<T>(v[i * 4], v[i * 4 + 1], v[i * 4 + 2], v[i * 4 + 3]);
+	}
+
+	void evaluateTarget(
+		Target         target,
+		T              time,
+		Vector<3, T> & t,
+		Quaternion<T> &r,
+		Vector<3, T> & s) {
+		const auto &tracks = _targets[target];
+		t = Vector<3, T>(0, 0, 0);
+		r = Quaternion<T>();
+		s = Vector<3, T>(1, 1, 1);
+		if (tracks[0] != None) evaluate(tracks[0], time, t.data());
+		if (tracks[1] != None) evaluate(tracks[1], time, r.data());
+		if (tracks[2] != None) evaluate(tracks[2], time, s.data());
+	}
+
+	// translation * rotation * scale
+	static Affine3<T> compose(
+		const Vector<3, T> &t, const Quaternion<T> &r, const Vector<3, T> &s) {
+		Affine3<T> m = r.toAffine(t);
+		m.a11 *= s.x(), m.a21 *= s.x(), m.a31 *= s.x();
+		m.a12 *= s.y(), m.a22 *= s.y(), m.a32 *= s.y();
+		m.a13 *= s.z(), m.a23 *= s.z(), m.a33 *= s.z();
+		return m;
+	}
+
+public:
+	AnimationClip() {}
+
+	size_t targets() const { return _targets.size(); }
+	size_t tracks() const { return _keyCount.size(); }
+
+	// Time range covered by the keys of all tracks.
+	T startTime() const { return _start; }
+	T endTime() const { return _end; }
+
+	// Adds a track of count keys with ascending times, replacing any previous
+	// track for the same target and channel. values holds 3 components per key,
+	// or 4 for rotations given as quaternions (x, y, z, w).
+	Track addTrack(
+		Target           target,
+		AnimationChannel channel,
+		const T *        times,
+		const T *        values,
+		size_t           count,
+		Interpolation    interpolation = Interpolation::Linear) {
+		if (count == 0) return None;
+
+		const Track  k = _keyCount.size();
+		const size_t d = components(channel);
+
+		if (k == 0 || times[0] < _start) _start = times[0];
+		if (k == 0 || times[count - 1] > _end) _end = times[count - 1];
+
+		_keyBegin.push_back(_times.size());
+		_keyCount.push_back(count);
+		_valueBegin.push_back(_values.size());
+		_cursor.push_back(0);
+		_interpolation.push_back(interpolation);
+		_channel.push_back(channel);
+		_times.insert(_times.end(), times, times + count);
+		_values.insert(_values.end(), values, values + count * d);
+
+		if (target >= _targets.size())
+			_targets.resize(target + 1, {None, None, None});
+		_targets[target][size_t(channel)] = k;
+		return k;
+	}
+
+	Track addTranslation(
+		Target              target,
+		const T *           times,
+		const Vector<3, T> *values,
+		size_t              count,
+		Interpolation       interpolation = Interpolation::Linear) {
+		return addTrack(
+			target,
+			AnimationChannel::Translation,
+			times,
+			values->data(),
+			count,
+			interpolation);
+	}
+	Track addRotation(
+		Target               target,
+		const T *            times,
+		const Quaternion<T> *values,
+		size_t               count,
+		Interpolation        interpolation = Interpolation::Linear) {
+		return addTrack(
+			target,
+			AnimationChannel::Rotation,
+			times,
+			values->data(),
+			count,
+			interpolation);
+	}
+	Track addScale(
+		Target              target,
+		const T *           times,
+		const Vector<3, T> *values,
+		size_t              count,
+		Interpolation       interpolation = Interpolation::Linear) {
+		return addTrack(
+			target,
+			AnimationChannel::Scale,
+			times,
+			values->data(),
+			count,
+			interpolation);
+	}
+
+	Track track(Target target, AnimationChannel channel) const {
+		return target < _targets.size() ? _targets[target][size_t(channel)] : None;
+	}
+
+	// Evaluates a single track into 3 or 4 components.
+	void sampleTrack(Track k, T time, T *res) { evaluate(k, time, res); }
+
+	// Forgets the cached key positions, e.g. after seeking backwards.
+	void resetCursors() { std::fill(_cursor.begin(), _cursor.end(), 0); }
+
+	// Samples the components of every target at time. Targets without a track
+	// for a channel get the identity, null outputs are skipped.
+	void sample(
+		T              time,
+		Vector<3, T> * translations,
+		Quaternion<T> *rotations,
+		Vector<3, T> * scales) {
+		parallelFor(0, _targets.size(), Grain, [&](size_t b, size_t e) {
+			for (size_t i = b; i < e; i++) {
+				Vector<3, T>  t, s;
+				Quaternion<T> r;
+				evaluateTarget(i, time, t, r, s);
+				if (translations) translations[i] = t;
+				if (rotations) rotations[i] = r;
+				if (scales) scales[i] = s;
+			}
+		});
+	}
+
+	// Samples the local transform of every target at time.
+	void sample(T time, Affine3<T> *res) {
+		parallelFor(0, _targets.size(), Grain, [&](size_t b, size_t e) {
+			for (size_t i = b; i < e; i++) {
+				Vector<3, T>  t, s;
+				Quaternion<T> r;
+				evaluateTarget(i, time, t, r, s);
+				res[i] = compose(t, r, s);
+			}
+		});
+	}
+	template<matrix_storage_type_t stor>
+	void sample(T time, Matrix4<T, stor> *res) {
+		parallelFor(0, _targets.size(), Grain, [&](size_t b, size_t e) {
+			for (size_t i = b; i < e; i++) {
+				Vector<3, T>  t, s;
+				Quaternion<T> r;
+				evaluateTarget(i, time, t, r, s);
+				res[i] = compose(t, r, s).template toMatrix<stor>();
+			}
+		});
+	}
+};
+
+typedef AnimationClip<float>  AnimationClipf;
+typedef AnimationClip<double> AnimationClipd;
+
+} // namespace alp
+
+extern template class alp::AnimationClip<float>;
+extern template class alp::AnimationClip<double>;
+#endif
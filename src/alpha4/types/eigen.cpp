@@ -0,0 +1,54 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "eigen.hpp"
+
+#include "alpha4/common/parallel.hpp"
+
+namespace alp {
+
+template<typename T>
+void eigensystems(
+	const SymmetricMatrix3<T> *matrices, Eigensystem3<T> *res, size_t count) {
+	parallelFor(0, count, 4096, [matrices, res](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			res[i] = matrices[i].eigensystem();
+	});
+}
+
+template<typename T>
+void smallestEigenvectors(
+	const SymmetricMatrix3<T> *matrices, Vector<3, T> *res, size_t count) {
+	parallelFor(0, count, 4096, [matrices, res](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			res[i] = matrices[i].smallestEigenvector();
+	});
+}
+
+template void eigensystems<float>(
+	const SymmetricMatrix3<float> *, Eigensystem3<float> *, size_t);
+template void eigensystems<double>(
+	const SymmetricMatrix3<double> *, Eigensystem3<double> *, size_t);
+template void smallestEigenvectors<float>(
+	const SymmetricMatrix3<float> *, Vector<3, float> *, size_t);
+template void smallestEigenvectors<double>(
+	const SymmetricMatrix3<double> *, Vector<3, double> *, size_t);
+
+} // namespace alp
+
+template struct alp::SymmetricMatrix3<float>;
+template struct alp::SymmetricMatrix3<double>;
@@ -0,0 +1,241 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_EIGEN_HPP
+#define ALPHA4_TYPES_EIGEN_HPP
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/util.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace alp {
+
+// Eigenvalues in ascending order and the matching orthonormal eigenvectors,
+// forming a right-handed basis.
+template<typename T> struct Eigensystem3 {
+	Vector<3, T>                values;
+	std::array<Vector<3, T>, 3> vectors;
+};
+
+// Symmetric 3x3 matrix storing only the upper triangle.
+template<typename T> struct SymmetricMatrix3 {
+	T xx = 0, xy = 0, xz = 0;
+	T yy = 0, yz = 0;
+	T zz = 0;
+
+	// Takes the upper triangle of the upper left 3x3 block.
+	template<matrix_storage_type_t stor>
+	static SymmetricMatrix3 FromMatrix(const Matrix4<T, stor> &m) {
+		return {m.a11, m.a12, m.a13, m.a22, m.a23, m.a33};
+	}
+
+	// Covariance of a point set around its centroid, normalized by the point
+	// count.
+	static SymmetricMatrix3 Covariance(const Vector<3, T> *points, size_t count) {
+		SymmetricMatrix3 res;
+		if (count < 1) return res;
+
+		Vector<3, T> c;
+		for (size_t i = 0; i < count; i++)
+			c += points[i];
+		c /= T(count);
+
+		for (size_t i = 0; i < count; i++) {
+			const Vector<3, T> d = points[i] - c;
+			res.xx += d.x() * d.x();
+			res.xy += d.x() * d.y();
+			res.xz += d.x() * d.z();
+			res.yy += d.y() * d.y();
+			res.yz += d.y() * d.z();
+			res.zz += d.z() * d.z();
+		}
+		const T f = T(1) / T(count);
+		res.xx *= f;
+		res.xy *= f;
+		res.xz *= f;
+		res.yy *= f;
+		res.yz *= f;
+		res.zz *= f;
+		return res;
+	}
+
+	Vector<3, T> operator*(const Vector<3, T> &v) const {
+		return {
+			xx * v.x() + xy * v.y() + xz * v.z(),
+			xy * v.x() + yy * v.y() + yz * v.z(),
+			xz * v.x() + yz * v.y() + zz * v.z()};
+	}
+
+	// Closed-form eigenvalues followed by eigenvectors computed for the best
+	// separated eigenvalue first, the second one inside its orthogonal
+	// complement and the third by cross product (Eberly, "A Robust Eigensolver
+	// for 3x3 Symmetric Matrices"). Stays accurate for repeated eigenvalues.
+	Eigensystem3<T> eigensystem() const {
+		Eigensystem3<T> res;
+
+		// scale to avoid over- and underflow of the cubic terms
+		const T scale = std::max(
+			{std::abs(xx),
+			 std::abs(xy),
+			 std::abs(xz),
+			 std::abs(yy),
+			 std::abs(yz),
+			 std::abs(zz)});
+		if (!(scale > 0)) {
+			res.vectors = {
+				Vector<3, T>(1, 0, 0), Vector<3, T>(0, 1, 0), Vector<3, T>(0, 0, 1)};
+			return res;
+		}
+		const T          inv = T(1) / scale;
+		SymmetricMatrix3 a{
+			xx * inv, xy * inv, xz * inv, yy * inv, yz * inv, zz * inv};
+
+		const T norm = a.xy * a.xy + a.xz * a.xz + a.yz * a.yz;
+		if (!(norm > 0)) {
+			// diagonal, sort the axes by value
+			std::array<std::pair<T, unsigned>, 3> d = {
+				std::pair<T, unsigned>(xx, 0),
+				std::pair<T, unsigned>(yy, 1),
+				std::pair<T, unsigned>(zz, 2)};
+			std::sort(d.begin(), d.end());
+			for (unsigned i = 0; i < 3; i++) {
+				res.values[i]               = d[i].first;
+				res.vectors[i]              = Vector<3, T>();
+				res.vectors[i][d[i].second] = 1;
+			}
+			if (((res.vectors[0] % res.vectors[1]) * res.vectors[2]) < 0)
+				res.vectors[2] *= T(-1);
+			return res;
+		}
+
+		const T q   = (a.xx + a.yy + a.zz) / T(3);
+		const T b00 = a.xx - q, b11 = a.yy - q, b22 = a.zz - q;
+		const T p =
+			std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 + 2 * norm) / T(6));
+		const T c00     = b11 * b22 - a.yz * a.yz;
+		const T c01     = a.xy * b22 - a.yz * a.xz;
+		const T c02     = a.xy * a.yz - b11 * a.xz;
+		const T det     = (b00 * c00 - a.xy * c01 + a.xz * c02) / (p * p * p);
+		const T halfDet = std::clamp(det * T(0.5), T(-1), T(1));
+
+		const T angle = std::acos(halfDet) / T(3);
+		const T beta2 = std::cos(angle) * 2;
+		const T beta0 =
+			std::cos(angle + T(2) * T(constants<double>::pi) / T(3)) * 2;
+		const T beta1 = -(beta0 + beta2);
+
+		res.values = {q + p * beta0, q + p * beta1, q + p * beta2};
+		// rounding may swap nearly repeated eigenvalues
+		res.values[1] = std::clamp(res.values[1], res.values[0], res.values[2]);
+
+		if (halfDet >= 0) {
+			res.vectors[2] = a.eigenvector0(res.values[2]);
+			res.vectors[1] = a.eigenvector1(res.vectors[2], res.values[1]);
+			res.vectors[0] = res.vectors[1] % res.vectors[2];
+		} else {
+			res.vectors[0] = a.eigenvector0(res.values[0]);
+			res.vectors[1] = a.eigenvector1(res.vectors[0], res.values[1]);
+			res.vectors[2] = res.vectors[0] % res.vectors[1];
+		}
+
+		res.values *= scale;
+		return res;
+	}
+
+	// Eigenvector of the smallest eigenvalue, e.g. the normal of a point
+	// neighbourhood given its covariance.
+	Vector<3, T> smallestEigenvector() const { return eigensystem().vectors[0]; }
+
+protected:
+	// Eigenvector of a simple eigenvalue as the largest cross product of two rows
+	// of A - value * I.
+	Vector<3, T> eigenvector0(T value) const {
+		const Vector<3, T> r0(xx - value, xy, xz);
+		const Vector<3, T> r1(xy, yy - value, yz);
+		const Vector<3, T> r2(xz, yz, zz - value);
+
+		const Vector<3, T> c01 = r0 % r1, c02 = r0 % r2, c12 = r1 % r2;
+		const T d01 = c01.square(), d02 = c02.square(), d12 = c12.square();
+
+		if (d01 >= d02 && d01 >= d12) return c01 / std::sqrt(d01);
+		if (d02 >= d12) return c02 / std::sqrt(d02);
+		return c12 / std::sqrt(d12);
+	}
+
+	Vector<3, T> eigenvector1(const Vector<3, T> &v0, T value) const {
+		// orthonormal basis u, v of the complement of v0
+		Vector<3, T> u;
+		if (std::abs(v0.x()) > std::abs(v0.y()))
+			u = Vector<3, T>(-v0.z(), 0, v0.x()) / std::hypot(v0.x(), v0.z());
+		else
+			u = Vector<3, T>(0, v0.z(), -v0.y()) / std::hypot(v0.y(), v0.z());
+		const Vector<3, T> v = v0 % u;
+
+		const Vector<3, T> au = (*this) * u, av = (*this) * v;
+		T m00 = u * au - value, m01 = u * av, m11 = v * av - value;
+		const T a00 = std::abs(m00), a01 = std::abs(m01), a11 = std::abs(m11);
+
+		if (a00 >= a11) {
+			if (std::max(a00, a01) > 0) {
+				if (a00 >= a01) {
+					m01 /= m00;
+					m00 = T(1) / std::sqrt(1 + m01 * m01);
+					m01 *= m00;
+				} else {
+					m00 /= m01;
+					m01 = T(1) / std::sqrt(1 + m00 * m00);
+					m00 *= m01;
+				}
+				return u * m01 - v * m00;
+			}
+		} else {
+			if (std::max(a11, a01) > 0) {
+				if (a11 >= a01) {
+					m01 /= m11;
+					m11 = T(1) / std::sqrt(1 + m01 * m01);
+					m01 *= m11;
+				} else {
+					m11 /= m01;
+					m01 = T(1) / std::sqrt(1 + m11 * m11);
+					m11 *= m01;
+				}
+				return u * m11 - v * m01;
+			}
+		}
+		return u;
+	}
+};
+
+typedef SymmetricMatrix3<float>  symmat3f;
+typedef SymmetricMatrix3<double> symmat3d;
+
+// Batch forms, split across threads for large counts.
+template<typename T>
+void eigensystems(
+	const SymmetricMatrix3<T> *matrices, Eigensystem3<T> *res, size_t count);
+template<typename T>
+void smallestEigenvectors(
+	const SymmetricMatrix3<T> *matrices, Vector<3, T> *res, size_t count);
+
+} // namespace alp
+
+extern template struct alp::SymmetricMatrix3<float>;
+extern template struct alp::SymmetricMatrix3<double>;
+#endif
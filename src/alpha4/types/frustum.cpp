@@ -0,0 +1,185 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "frustum.hpp"
+
+#include "alpha4/common/simd.hpp"
+
+#ifdef ALPHA4_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace alp {
+namespace {
+
+template<typename T>
+size_t cullBoxesScalar(
+	const Frustum<T> &f,
+	const BoxArray<T> &b,
+	size_t             first,
+	uint32_t *         visible) {
+	size_t n = 0;
+	for (size_t i = first; i < b.count; i++) {
+		if (f.intersectsBox(
+					{b.minX[i], b.minY[i], b.minZ[i]}, {b.maxX[i], b.maxY[i], b.maxZ[i]}))
+			visible[n++] = uint32_t(i);
+	}
+	return n;
+}
+
+template<typename T>
+size_t cullSpheresScalar(
+	const Frustum<T> &   f,
+	const SphereArray<T> &s,
+	size_t                first,
+	uint32_t *            visible) {
+	size_t n = 0;
+	for (size_t i = first; i < s.count; i++) {
+		if (f.intersectsSphere({s.x[i], s.y[i], s.z[i]}, s.r[i]))
+			visible[n++] = uint32_t(i);
+	}
+	return n;
+}
+
+#ifdef ALPHA4_SIMD_X86
+inline size_t
+emitIndices(unsigned mask, size_t base, uint32_t *visible) {
+	size_t n = 0;
+	while (mask) {
+		visible[n++] = uint32_t(base + __builtin_ctz(mask));
+		mask &= mask - 1;
+	}
+	return n;
+}
+
+ALPHA4_TARGET_AVX2 size_t cullBoxesAVX2(
+	const Frustum<float> &f, const BoxArray<float> &b, uint32_t *visible) {
+	const __m256 half    = _mm256_set1_ps(0.5f);
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+	__m256 pa[6], pb[6], pc[6], pd[6], aa[6], ab[6], ac[6];
+	for (unsigned p = 0; p < 6; p++) {
+		const auto &pl = f.planes[p];
+		pa[p]          = _mm256_set1_ps(pl.x());
+		pb[p]          = _mm256_set1_ps(pl.y());
+		pc[p]          = _mm256_set1_ps(pl.z());
+		pd[p]          = _mm256_set1_ps(pl.w());
+		aa[p]          = _mm256_andnot_ps(signBit, pa[p]);
+		ab[p]          = _mm256_andnot_ps(signBit, pb[p]);
+		ac[p]          = _mm256_andnot_ps(signBit, pc[p]);
+	}
+
+	size_t n = 0, i = 0;
+	for (; i + 8 <= b.count; i += 8) {
+		const __m256 x0 = _mm256_loadu_ps(b.minX + i);
+		const __m256 y0 = _mm256_loadu_ps(b.minY + i);
+		const __m256 z0 = _mm256_loadu_ps(b.minZ + i);
+		const __m256 x1 = _mm256_loadu_ps(b.maxX + i);
+		const __m256 y1 = _mm256_loadu_ps(b.maxY + i);
+		const __m256 z1 = _mm256_loadu_ps(b.maxZ + i);
+
+		const __m256 cx = _mm256_mul_ps(_mm256_add_ps(x0, x1), half);
+		const __m256 cy = _mm256_mul_ps(_mm256_add_ps(y0, y1), half);
+		const __m256 cz = _mm256_mul_ps(_mm256_add_ps(z0, z1), half);
+		const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(x1, x0), half);
+		const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(y1, y0), half);
+		const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(z1, z0), half);
+
+		__m256 outside = _mm256_setzero_ps();
+		for (unsigned p = 0; p < 6; p++) {
+			// same evaluation order as the scalar path
+			__m256 d = _mm256_add_ps(
+				_mm256_mul_ps(pa[p], cx), _mm256_mul_ps(pb[p], cy));
+			d        = _mm256_add_ps(d, _mm256_mul_ps(pc[p], cz));
+			d        = _mm256_add_ps(d, pd[p]);
+			__m256 r = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(aa[p], ex), _mm256_mul_ps(ab[p], ey)),
+				_mm256_mul_ps(ac[p], ez));
+			outside = _mm256_or_ps(
+				outside,
+				_mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+		const unsigned mask = ~unsigned(_mm256_movemask_ps(outside)) & 0xff;
+		n += emitIndices(mask, i, visible + n);
+	}
+	return n + cullBoxesScalar(f, b, i, visible + n);
+}
+
+ALPHA4_TARGET_AVX2 size_t cullSpheresAVX2(
+	const Frustum<float> &f, const SphereArray<float> &s, uint32_t *visible) {
+	__m256 pa[6], pb[6], pc[6], pd[6];
+	for (unsigned p = 0; p < 6; p++) {
+		const auto &pl = f.planes[p];
+		pa[p]          = _mm256_set1_ps(pl.x());
+		pb[p]          = _mm256_set1_ps(pl.y());
+		pc[p]          = _mm256_set1_ps(pl.z());
+		pd[p]          = _mm256_set1_ps(pl.w());
+	}
+
+	size_t n = 0, i = 0;
+	for (; i + 8 <= s.count; i += 8) {
+		const __m256 x = _mm256_loadu_ps(s.x + i), y = _mm256_loadu_ps(s.y + i),
+								 z = _mm256_loadu_ps(s.z + i), r = _mm256_loadu_ps(s.r + i);
+
+		__m256 outside = _mm256_setzero_ps();
+		for (unsigned p = 0; p < 6; p++) {
+			// same evaluation order as the scalar path
+			__m256 d = _mm256_add_ps(
+				_mm256_mul_ps(pa[p], x), _mm256_mul_ps(pb[p], y));
+			d        = _mm256_add_ps(d, _mm256_mul_ps(pc[p], z));
+			d        = _mm256_add_ps(d, pd[p]);
+			outside = _mm256_or_ps(
+				outside,
+				_mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+		const unsigned mask = ~unsigned(_mm256_movemask_ps(outside)) & 0xff;
+		n += emitIndices(mask, i, visible + n);
+	}
+	return n + cullSpheresScalar(f, s, i, visible + n);
+}
+#endif
+
+} // namespace
+
+template<typename T>
+size_t
+Frustum<T>::cullBoxes(const BoxArray<T> &boxes, uint32_t *visible) const {
+#ifdef ALPHA4_SIMD_X86
+	if constexpr (std::is_same_v<T, float>) {
+		if (activeIsa() >= Isa::AVX2)
+			return cullBoxesAVX2(*this, boxes, visible);
+	}
+#endif
+	return cullBoxesScalar(*this, boxes, 0, visible);
+}
+
+template<typename T>
+size_t Frustum<T>::cullSpheres(
+	const SphereArray<T> &spheres, uint32_t *visible) const {
+#ifdef ALPHA4_SIMD_X86
+	if constexpr (std::is_same_v<T, float>) {
+		if (activeIsa() >= Isa::AVX2)
+			return cullSpheresAVX2(*this, spheres, visible);
+	}
+#endif
+	return cullSpheresScalar(*this, spheres, 0, visible);
+}
+
+} // namespace alp
+
+template struct alp::Frustum<float>;
+template struct alp::Frustum<double>;
@@ -0,0 +1,114 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_FRUSTUM_HPP
+#define ALPHA4_TYPES_FRUSTUM_HPP
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace alp {
+
+// Structure-of-arrays views over bounding volumes, as consumed by the batch
+// culling kernels.
+template<typename T> struct BoxArray {
+	const T *minX, *minY, *minZ;
+	const T *maxX, *maxY, *maxZ;
+	size_t   count;
+};
+
+template<typename T> struct SphereArray {
+	const T *x, *y, *z;
+	const T *r;
+	size_t   count;
+};
+
+// Six clip planes (a,b,c,d), normalized so that a*x+b*y+c*z+d is the signed
+// distance to the plane, positive on the inside.
+template<typename T> struct Frustum {
+	enum Plane { Left, Right, Bottom, Top, Near, Far };
+
+	std::array<Vector<4, T>, 6> planes;
+
+	// Extracts the planes of the clip volume -w <= x,y,z <= w of a
+	// view-projection matrix. Points are transformed as column vectors, m * p.
+	template<matrix_storage_type_t stor>
+	static Frustum FromMatrix(const Matrix4<T, stor> &m) {
+		const Vector<4, T> r1 = m.row1(), r2 = m.row2(), r3 = m.row3(),
+											 r4 = m.row4();
+		Frustum f;
+		f.planes[Left]   = r4 + r1;
+		f.planes[Right]  = r4 - r1;
+		f.planes[Bottom] = r4 + r2;
+		f.planes[Top]    = r4 - r2;
+		f.planes[Near]   = r4 + r3;
+		f.planes[Far]    = r4 - r3;
+		for (auto &p : f.planes) {
+			const T n = p.xyz().norm();
+			if (n > 0) p /= n;
+		}
+		return f;
+	}
+
+	T distance(Plane i, const Vector<3, T> &p) const {
+		const auto &pl = planes[i];
+		return pl.x() * p.x() + pl.y() * p.y() + pl.z() * p.z() + pl.w();
+	}
+
+	bool contains(const Vector<3, T> &p) const {
+		for (unsigned i = 0; i < 6; i++)
+			if (distance(Plane(i), p) < 0) return false;
+		return true;
+	}
+
+	bool intersectsSphere(const Vector<3, T> &c, T r) const {
+		for (unsigned i = 0; i < 6; i++)
+			if (distance(Plane(i), c) + r < 0) return false;
+		return true;
+	}
+
+	// Conservative test: boxes straddling two planes outside a frustum corner
+	// are reported visible.
+	bool intersectsBox(const Vector<3, T> &min, const Vector<3, T> &max) const {
+		const Vector<3, T> c = (min + max) * T(0.5), e = (max - min) * T(0.5);
+		for (const auto &pl : planes) {
+			const T d = pl.x() * c.x() + pl.y() * c.y() + pl.z() * c.z() + pl.w();
+			const T r = std::abs(pl.x()) * e.x() + std::abs(pl.y()) * e.y()
+				+ std::abs(pl.z()) * e.z();
+			if (d + r < 0) return false;
+		}
+		return true;
+	}
+
+	// Writes the indices of all potentially visible volumes to visible, which
+	// must hold count entries, and returns how many were written. Float inputs
+	// are tested eight at a time on AVX capable machines.
+	size_t cullBoxes(const BoxArray<T> &boxes, uint32_t *visible) const;
+	size_t cullSpheres(const SphereArray<T> &spheres, uint32_t *visible) const;
+};
+
+typedef Frustum<float>  frustumf;
+typedef Frustum<double> frustumd;
+
+} // namespace alp
+
+extern template struct alp::Frustum<float>;
+extern template struct alp::Frustum<double>;
+#endif
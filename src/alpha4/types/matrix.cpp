@@ -17,5 +17,91 @@ Alpha4. If not, see <https://www.gnu.org/licenses/>.
 
 #include "matrix.hpp"
 
+#include "alpha4/common/fastmath.hpp"
+
+#include <algorithm>
+
+namespace alp {
+
+namespace {
+
+// Evaluates the angles in blocks and hands each sine/cosine pair to build.
+template<typename T, typename F>
+void buildRotations(const T *angles, size_t count, const F &build) {
+	constexpr size_t Block = 256;
+	T                s[Block], c[Block];
+	for (size_t b = 0; b < count; b += Block) {
+		const size_t n = std::min(Block, count - b);
+		fastSincos(angles + b, s, c, n);
+		for (size_t i = 0; i < n; i++)
+			build(b + i, s[i], c[i]);
+	}
+}
+
+} // namespace
+
+template<typename T, matrix_storage_type_t stor>
+void Matrix4<T, stor>::RotationX(
+	const T *angles, Matrix4 *res, size_t count) {
+	buildRotations(angles, count, [res](size_t i, T s, T c) {
+		// clang-format off
+		res[i].set(
+			1, 0,  0, 0,
+			0, c, -s, 0,
+			0, s,  c, 0,
+			0, 0,  0, 1);
+		// clang-format on
+	});
+}
+
+template<typename T, matrix_storage_type_t stor>
+void Matrix4<T, stor>::RotationY(
+	const T *angles, Matrix4 *res, size_t count) {
+	buildRotations(angles, count, [res](size_t i, T s, T c) {
+		// clang-format off
+		res[i].set(
+			c, 0, s, 0,
+			0, 1, 0, 0,
+			-s, 0, c, 0,
+			0, 0, 0, 1);
+		// clang-format on
+	});
+}
+
+template<typename T, matrix_storage_type_t stor>
+void Matrix4<T, stor>::RotationZ(
+	const T *angles, Matrix4 *res, size_t count) {
+	buildRotations(angles, count, [res](size_t i, T s, T c) {
+		// clang-format off
+		res[i].set(
+			c, -s, 0, 0,
+			s,  c, 0, 0,
+			0,  0, 1, 0,
+			0,  0, 0, 1);
+		// clang-format on
+	});
+}
+
+template<typename T, matrix_storage_type_t stor>
+void Matrix4<T, stor>::Rotation(
+	const T *angles, const Vector<3, T> &axis, Matrix4 *res, size_t count) {
+	const Vector<3, T> u = axis.normalized();
+	const T            x = u.x(), y = u.y(), z = u.z();
+	buildRotations(angles, count, [res, x, y, z](size_t i, T sn, T cs) {
+		const T cn = 1 - cs;
+		// clang-format off
+		res[i].set(
+			cn*x*x+  cs, cn*x*y-z*sn, cn*x*z+y*sn, 0,
+			cn*x*y+z*sn, cn*y*y+  cs, cn*y*z-x*sn, 0,
+			cn*x*z-y*sn, cn*y*z+x*sn, cn*z*z+  cs, 0,
+			0          , 0          , 0          , 1);
+		// clang-format on
+	});
+}
+
+} // namespace alp
+
 template struct alp::Matrix4<float>;
-template struct alp::Matrix4<double>;
\ No newline at end of file
+template struct alp::Matrix4<double>;
+template struct alp::Matrix4<float, alp::COLUMN_MAJOR>;
+template struct alp::Matrix4<double, alp::COLUMN_MAJOR>;
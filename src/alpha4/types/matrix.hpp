@@ -297,6 +297,14 @@ public:
 		// clang-format on
 	}
 
+	// Batch builders over arrays of angles, evaluated with the vectorized
+	// fastSincos. Only available for float and double.
+	static void RotationX(const T *angles, Matrix4 *res, size_t count);
+	static void RotationY(const T *angles, Matrix4 *res, size_t count);
+	static void RotationZ(const T *angles, Matrix4 *res, size_t count);
+	static void Rotation(
+		const T *angles, const Vector<3, T> &axis, Matrix4 *res, size_t count);
+
 	void setTranslation(T x, T y, T z) {
 		// clang-format off
 			set(
@@ -725,4 +733,6 @@ typedef Matrix4<double> mat4d;
 
 extern template struct alp::Matrix4<float>;
 extern template struct alp::Matrix4<double>;
+extern template struct alp::Matrix4<float, alp::COLUMN_MAJOR>;
+extern template struct alp::Matrix4<double, alp::COLUMN_MAJOR>;
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "matrixarray.hpp"
+
+#include "alpha4/common/parallel.hpp"
+
+#include <stdexcept>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace alp {
+namespace {
+
+bool validLayout(MatrixLayout layout) {
+	return layout == MatrixLayout::RowMajor || layout == MatrixLayout::ColumnMajor
+		|| layout == MatrixLayout::RowMajor3x4;
+}
+
+// Every matrix is fully read into registers before it is written, so source
+// and destination may alias. Layouts are validated by the caller.
+template<typename Src, typename Dst>
+void convertRange(
+	const MatrixArrayView<Src> &src,
+	Dst *                       dst,
+	MatrixLayout                dstLayout,
+	size_t                      begin,
+	size_t                      end) {
+	const size_t dstElements = matrixElements(dstLayout);
+	for (size_t i = begin; i < end; i++) {
+		const Src *s = src[i];
+		Dst *      d = dst + i * dstElements;
+
+		Src r[16];
+		switch (src.layout) {
+			case MatrixLayout::RowMajor:
+				for (size_t k = 0; k < 16; k++)
+					r[k] = s[k];
+				break;
+			case MatrixLayout::ColumnMajor:
+				for (size_t row = 0; row < 4; row++)
+					for (size_t col = 0; col < 4; col++)
+						r[row * 4 + col] = s[col * 4 + row];
+				break;
+			case MatrixLayout::RowMajor3x4:
+				for (size_t k = 0; k < 12; k++)
+					r[k] = s[k];
+				r[12] = r[13] = r[14] = Src(0);
+				r[15]                 = Src(1);
+				break;
+			default: __builtin_unreachable();
+		}
+
+		switch (dstLayout) {
+			case MatrixLayout::RowMajor:
+				for (size_t k = 0; k < 16; k++)
+					d[k] = Dst(r[k]);
+				break;
+			case MatrixLayout::ColumnMajor:
+				for (size_t col = 0; col < 4; col++)
+					for (size_t row = 0; row < 4; row++)
+						d[col * 4 + row] = Dst(r[row * 4 + col]);
+				break;
+			case MatrixLayout::RowMajor3x4:
+				for (size_t k = 0; k < 12; k++)
+					d[k] = Dst(r[k]);
+				break;
+		}
+	}
+}
+
+#if defined(__SSE__)
+void convertRangeSSE(
+	const MatrixArrayView<float> &src,
+	float *                       dst,
+	MatrixLayout                  dstLayout,
+	size_t                        begin,
+	size_t                        end) {
+	const size_t dstElements = matrixElements(dstLayout);
+	const bool   srcCols     = src.layout == MatrixLayout::ColumnMajor;
+	const bool   src3x4      = src.layout == MatrixLayout::RowMajor3x4;
+	const bool   dstCols     = dstLayout == MatrixLayout::ColumnMajor;
+	const size_t dstRows     = dstLayout == MatrixLayout::RowMajor3x4 ? 3 : 4;
+	const __m128 lastRow     = _mm_setr_ps(0, 0, 0, 1);
+
+	for (size_t i = begin; i < end; i++) {
+		const float *s = src[i];
+		float *      d = dst + i * dstElements;
+
+		__m128 r0 = _mm_loadu_ps(s + 0);
+		__m128 r1 = _mm_loadu_ps(s + 4);
+		__m128 r2 = _mm_loadu_ps(s + 8);
+		__m128 r3 = src3x4 ? lastRow : _mm_loadu_ps(s + 12);
+
+		// transposing twice cancels out
+		if (srcCols != dstCols) _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(d + 0, r0);
+		_mm_storeu_ps(d + 4, r1);
+		_mm_storeu_ps(d + 8, r2);
+		if (dstRows > 3) _mm_storeu_ps(d + 12, r3);
+	}
+}
+#endif
+
+} // namespace
+
+template<typename Src, typename Dst>
+void convertMatrices(
+	const MatrixArrayView<Src> &src, Dst *dst, MatrixLayout dstLayout) {
+	if (!validLayout(src.layout) || !validLayout(dstLayout))
+		throw std::invalid_argument("invalid matrix layout");
+	auto kernel = [&](size_t b, size_t e) {
+#if defined(__SSE__)
+		if constexpr (std::is_same_v<Src, float> && std::is_same_v<Dst, float>) {
+			convertRangeSSE(src, dst, dstLayout, b, e);
+			return;
+		}
+#endif
+		convertRange(src, dst, dstLayout, b, e);
+	};
+	parallelFor(0, src.count, 1 << 14, kernel);
+}
+
+template void convertMatrices<float, float>(
+	const MatrixArrayView<float> &, float *, MatrixLayout);
+template void convertMatrices<float, double>(
+	const MatrixArrayView<float> &, double *, MatrixLayout);
+template void convertMatrices<double, float>(
+	const MatrixArrayView<double> &, float *, MatrixLayout);
+template void convertMatrices<double, double>(
+	const MatrixArrayView<double> &, double *, MatrixLayout);
+
+} // namespace alp
+
+template class alp::MatrixArray<float, alp::ROW_MAJOR>;
+template class alp::MatrixArray<float, alp::COLUMN_MAJOR>;
+template class alp::MatrixArray<double, alp::ROW_MAJOR>;
+template class alp::MatrixArray<double, alp::COLUMN_MAJOR>;
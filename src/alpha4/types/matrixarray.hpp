@@ -0,0 +1,154 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_MATRIXARRAY_HPP
+#define ALPHA4_TYPES_MATRIXARRAY_HPP
+#include "alpha4/types/matrix.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace alp {
+
+enum class MatrixLayout {
+	RowMajor,
+	ColumnMajor,
+	// upper three rows of a row-major matrix, the last row is (0, 0, 0, 1)
+	RowMajor3x4,
+};
+
+constexpr size_t matrixElements(MatrixLayout layout) {
+	return layout == MatrixLayout::RowMajor3x4 ? 12 : 16;
+}
+
+template<matrix_storage_type_t stor> constexpr MatrixLayout matrixLayout() {
+	return stor == ROW_MAJOR ? MatrixLayout::RowMajor : MatrixLayout::ColumnMajor;
+}
+
+// Strided view over consecutive matrices of a given layout. Matrix i starts at
+// data + i * stride.
+template<typename T> struct MatrixArrayView {
+	const T *    data   = nullptr;
+	size_t       count  = 0;
+	size_t       stride = 16;
+	MatrixLayout layout = MatrixLayout::RowMajor;
+
+	const T *operator[](size_t i) const { return data + i * stride; }
+	bool     packed() const { return stride == matrixElements(layout); }
+};
+
+// Converts the matrices of src into a packed array of dstLayout, converting
+// the scalar type as needed. Float matrices are transposed with SIMD shuffles.
+// Large arrays are split across threads. Throws std::invalid_argument if
+// either layout is not a MatrixLayout enumerator.
+template<typename Src, typename Dst>
+void convertMatrices(
+	const MatrixArrayView<Src> &src, Dst *dst, MatrixLayout dstLayout);
+
+// Packed array of Matrix4 with bulk conversion to other layouts and precisions.
+template<typename T, matrix_storage_type_t stor = ROW_MAJOR>
+class MatrixArray {
+public:
+	typedef Matrix4<T, stor> Matrix;
+	static_assert(sizeof(Matrix) == 16 * sizeof(T), "Matrix4 must be packed");
+
+	static constexpr const MatrixLayout Layout = matrixLayout<stor>();
+
+protected:
+	std::vector<Matrix> _m;
+
+public:
+	MatrixArray() {}
+	MatrixArray(size_t n) : _m(n) {}
+
+	size_t size() const { return _m.size(); }
+	bool   empty() const { return _m.empty(); }
+	void   resize(size_t n) { _m.resize(n); }
+	void   reserve(size_t n) { _m.reserve(n); }
+	void   clear() { _m.clear(); }
+	void   push_back(const Matrix &m) { _m.push_back(m); }
+
+	Matrix &      operator[](size_t i) { return _m[i]; }
+	const Matrix &operator[](size_t i) const { return _m[i]; }
+	Matrix *      data() { return _m.data(); }
+	const Matrix *data() const { return _m.data(); }
+	auto          begin() { return _m.begin(); }
+	auto          end() { return _m.end(); }
+	auto          begin() const { return _m.begin(); }
+	auto          end() const { return _m.end(); }
+
+	const T *scalars() const { return reinterpret_cast<const T *>(_m.data()); }
+	T *      scalars() { return reinterpret_cast<T *>(_m.data()); }
+
+	MatrixArrayView<T> view() const { return {scalars(), size(), 16, Layout}; }
+
+	// Zero-copy view in the requested layout, if the storage already matches.
+	// Row-major storage doubles as a strided 3x4 array.
+	std::optional<MatrixArrayView<T>> viewAs(MatrixLayout layout) const {
+		if (layout == Layout
+				|| (Layout == MatrixLayout::RowMajor
+						&& layout == MatrixLayout::RowMajor3x4))
+			return MatrixArrayView<T>{scalars(), size(), 16, layout};
+		return std::nullopt;
+	}
+
+	// Views the matrices as layout and scalar type U, without copying where
+	// possible and converting into scratch otherwise.
+	template<typename U = T>
+	MatrixArrayView<U> as(MatrixLayout layout, std::vector<U> &scratch) const {
+		if constexpr (std::is_same_v<T, U>) {
+			if (auto v = viewAs(layout); v) return *v;
+		}
+		scratch.resize(size() * matrixElements(layout));
+		convertMatrices(view(), scratch.data(), layout);
+		return {scratch.data(), size(), matrixElements(layout), layout};
+	}
+
+	// Bulk transposition into the other storage order, preserving the
+	// mathematical matrices.
+	template<matrix_storage_type_t stor2>
+	MatrixArray<T, stor2> toStorage() const {
+		MatrixArray<T, stor2> res(size());
+		convertMatrices(view(), res.scalars(), matrixLayout<stor2>());
+		return res;
+	}
+
+	// Bulk precision conversion, e.g. double to float.
+	template<typename U> MatrixArray<U, stor> cast() const {
+		MatrixArray<U, stor> res(size());
+		convertMatrices(view(), res.scalars(), Layout);
+		return res;
+	}
+
+	// Transposes every matrix in place.
+	void transposeAll() {
+		const MatrixLayout other = Layout == MatrixLayout::RowMajor
+			? MatrixLayout::ColumnMajor
+			: MatrixLayout::RowMajor;
+		// reading in the other layout and writing back in the native one
+		convertMatrices(
+			MatrixArrayView<T>{scalars(), size(), 16, other}, scalars(), Layout);
+	}
+};
+
+} // namespace alp
+
+extern template class alp::MatrixArray<float, alp::ROW_MAJOR>;
+extern template class alp::MatrixArray<float, alp::COLUMN_MAJOR>;
+extern template class alp::MatrixArray<double, alp::ROW_MAJOR>;
+extern template class alp::MatrixArray<double, alp::COLUMN_MAJOR>;
+#endif
@@ -0,0 +1,349 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "predicates.hpp"
+
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace alp {
+namespace {
+
+// Nonoverlapping expansion of at most N components, ordered by increasing
+// magnitude, whose exact sum is the represented value. Zero components are
+// eliminated, except for a single zero representing zero itself.
+template<size_t N> struct Expansion {
+	double v[N];
+	size_t n = 0;
+
+	int sign() const { return (v[n - 1] > 0) - (v[n - 1] < 0); }
+};
+
+inline void twoSum(double a, double b, double &x, double &y) {
+	x               = a + b;
+	const double bv = x - a, av = x - bv;
+	y               = (a - av) + (b - bv);
+}
+inline void fastTwoSum(double a, double b, double &x, double &y) {
+	x = a + b;
+	y = b - (x - a);
+}
+inline void twoProduct(double a, double b, double &x, double &y) {
+	x = a * b;
+	y = std::fma(a, b, -x);
+}
+
+Expansion<2> difference(double a, double b) {
+	Expansion<2> res;
+	double       x, y;
+	twoSum(a, -b, x, y);
+	if (y != 0) res.v[res.n++] = y;
+	res.v[res.n++] = x;
+	return res;
+}
+
+// h = e + f, Shewchuk's fast_expansion_sum_zeroelim.
+size_t
+	sumRaw(const double *e, size_t en, const double *f, size_t fn, double *h) {
+	size_t ei = 0, fi = 0, hi = 0;
+	double q, qn, hh;
+
+	// takes the smaller magnitude component next
+	auto nextE = [&]() {
+		if (fi >= fn) return true;
+		return ei < en && ((f[fi] > e[ei]) == (f[fi] > -e[ei]));
+	};
+
+	if (nextE())
+		q = e[ei++];
+	else
+		q = f[fi++];
+
+	if (ei < en && fi < fn) {
+		if (nextE())
+			fastTwoSum(e[ei++], q, qn, hh);
+		else
+			fastTwoSum(f[fi++], q, qn, hh);
+		q = qn;
+		if (hh != 0) h[hi++] = hh;
+	}
+	while (ei < en || fi < fn) {
+		if (nextE())
+			twoSum(q, e[ei++], qn, hh);
+		else
+			twoSum(q, f[fi++], qn, hh);
+		q = qn;
+		if (hh != 0) h[hi++] = hh;
+	}
+	if (q != 0 || hi == 0) h[hi++] = q;
+	return hi;
+}
+
+// h = e * b, Shewchuk's scale_expansion_zeroelim.
+size_t scaleRaw(const double *e, size_t en, double b, double *h) {
+	size_t hi = 0;
+	double q, hh, p1, p0, s;
+	twoProduct(e[0], b, q, hh);
+	if (hh != 0) h[hi++] = hh;
+	for (size_t i = 1; i < en; i++) {
+		twoProduct(e[i], b, p1, p0);
+		twoSum(q, p0, s, hh);
+		if (hh != 0) h[hi++] = hh;
+		fastTwoSum(p1, s, q, hh);
+		if (hh != 0) h[hi++] = hh;
+	}
+	if (q != 0 || hi == 0) h[hi++] = q;
+	return hi;
+}
+
+template<size_t A, size_t B>
+Expansion<A + B> operator+(const Expansion<A> &e, const Expansion<B> &f) {
+	Expansion<A + B> res;
+	res.n = sumRaw(e.v, e.n, f.v, f.n, res.v);
+	return res;
+}
+template<size_t A, size_t B>
+Expansion<A + B> operator-(const Expansion<A> &e, Expansion<B> f) {
+	for (size_t i = 0; i < f.n; i++)
+		f.v[i] = -f.v[i];
+	return e + f;
+}
+template<size_t A, size_t B>
+Expansion<2 * A * B> operator*(const Expansion<A> &e, const Expansion<B> &f) {
+	Expansion<2 * A * B> res, acc;
+	Expansion<2 * A>     term;
+	res.n = scaleRaw(e.v, e.n, f.v[0], res.v);
+	for (size_t i = 1; i < f.n; i++) {
+		term.n = scaleRaw(e.v, e.n, f.v[i], term.v);
+		acc.n  = sumRaw(res.v, res.n, term.v, term.n, acc.v);
+		res.n  = acc.n;
+		std::copy(acc.v, acc.v + acc.n, res.v);
+	}
+	return res;
+}
+
+using namespace simd;
+
+template<size_t B>
+ALPHA4_SIMD_INLINE void orient2dPacks(
+	const vec2d &a,
+	const vec2d &b,
+	const vec2d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	typedef pack_t<double, B> P;
+	for (size_t i = begin; i < end; i += Lanes<double, B>) {
+		const P cx = gather<double, B>(points[i].data(), 2);
+		const P cy = gather<double, B>(points[i].data() + 1, 2);
+
+		const P    l   = (a.x() - cx) * (b.y() - cy);
+		const P    r   = (a.y() - cy) * (b.x() - cx);
+		const P    det = l - r;
+		const P    sum = abs<double, B>(l) + abs<double, B>(r);
+		const P    err = PredicateBounds::orient2d * sum;
+		const auto ok  = (det >= err) | (-det >= err);
+
+		for (size_t k = 0; k < Lanes<double, B>; k++) {
+			res[i + k] = ok[k] ? int8_t((det[k] > 0) - (det[k] < 0))
+												 : int8_t(orient2dExact(a, b, points[i + k]));
+		}
+	}
+}
+
+template<size_t B>
+ALPHA4_SIMD_INLINE void orient3dPacks(
+	const vec3d &a,
+	const vec3d &b,
+	const vec3d &c,
+	const vec3d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	typedef pack_t<double, B> P;
+	for (size_t i = begin; i < end; i += Lanes<double, B>) {
+		const P dx = gather<double, B>(points[i].data(), 3);
+		const P dy = gather<double, B>(points[i].data() + 1, 3);
+		const P dz = gather<double, B>(points[i].data() + 2, 3);
+
+		const P adx = a.x() - dx, ady = a.y() - dy, adz = a.z() - dz;
+		const P bdx = b.x() - dx, bdy = b.y() - dy, bdz = b.z() - dz;
+		const P cdx = c.x() - dx, cdy = c.y() - dy, cdz = c.z() - dz;
+
+		const P bc = bdx * cdy, cb = cdx * bdy;
+		const P ca = cdx * ady, ac = adx * cdy;
+		const P ab = adx * bdy, ba = bdx * ady;
+
+		const P det = adz * (bc - cb) + bdz * (ca - ac) + cdz * (ab - ba);
+		const P permanent =
+			(abs<double, B>(bc) + abs<double, B>(cb)) * abs<double, B>(adz)
+			+ (abs<double, B>(ca) + abs<double, B>(ac)) * abs<double, B>(bdz)
+			+ (abs<double, B>(ab) + abs<double, B>(ba)) * abs<double, B>(cdz);
+		const P    err = PredicateBounds::orient3d * permanent;
+		const auto ok  = (det >= err) | (-det >= err);
+
+		for (size_t k = 0; k < Lanes<double, B>; k++) {
+			res[i + k] = ok[k] ? int8_t((det[k] > 0) - (det[k] < 0))
+												 : int8_t(orient3dExact(a, b, c, points[i + k]));
+		}
+	}
+}
+
+void orient2dPacksGeneric(
+	const vec2d &a,
+	const vec2d &b,
+	const vec2d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	orient2dPacks<PackBytes<Isa::Generic>>(a, b, points, res, begin, end);
+}
+void orient3dPacksGeneric(
+	const vec3d &a,
+	const vec3d &b,
+	const vec3d &c,
+	const vec3d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	orient3dPacks<PackBytes<Isa::Generic>>(a, b, c, points, res, begin, end);
+}
+
+#ifdef ALPHA4_SIMD_X86
+ALPHA4_TARGET_AVX2 void orient2dPacksAVX2(
+	const vec2d &a,
+	const vec2d &b,
+	const vec2d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	orient2dPacks<PackBytes<Isa::AVX2>>(a, b, points, res, begin, end);
+}
+
+ALPHA4_TARGET_AVX512 void orient2dPacksAVX512(
+	const vec2d &a,
+	const vec2d &b,
+	const vec2d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	orient2dPacks<PackBytes<Isa::AVX512>>(a, b, points, res, begin, end);
+}
+
+ALPHA4_TARGET_AVX2 void orient3dPacksAVX2(
+	const vec3d &a,
+	const vec3d &b,
+	const vec3d &c,
+	const vec3d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	orient3dPacks<PackBytes<Isa::AVX2>>(a, b, c, points, res, begin, end);
+}
+
+ALPHA4_TARGET_AVX512 void orient3dPacksAVX512(
+	const vec3d &a,
+	const vec3d &b,
+	const vec3d &c,
+	const vec3d *points,
+	int8_t *     res,
+	size_t       begin,
+	size_t       end) {
+	orient3dPacks<PackBytes<Isa::AVX512>>(a, b, c, points, res, begin, end);
+}
+#endif
+
+} // namespace
+
+int orient2dExact(const vec2d &a, const vec2d &b, const vec2d &c) {
+	const auto acx = difference(a.x(), c.x()), acy = difference(a.y(), c.y());
+	const auto bcx = difference(b.x(), c.x()), bcy = difference(b.y(), c.y());
+	return (acx * bcy - acy * bcx).sign();
+}
+
+int orient3dExact(
+	const vec3d &a, const vec3d &b, const vec3d &c, const vec3d &d) {
+	const auto adx = difference(a.x(), d.x()), ady = difference(a.y(), d.y()),
+						 adz = difference(a.z(), d.z());
+	const auto bdx = difference(b.x(), d.x()), bdy = difference(b.y(), d.y()),
+						 bdz = difference(b.z(), d.z());
+	const auto cdx = difference(c.x(), d.x()), cdy = difference(c.y(), d.y()),
+						 cdz = difference(c.z(), d.z());
+
+	const auto bc = bdx * cdy - cdx * bdy;
+	const auto ca = cdx * ady - adx * cdy;
+	const auto ab = adx * bdy - bdx * ady;
+	return (adz * bc + bdz * ca + cdz * ab).sign();
+}
+
+int incircleExact(
+	const vec2d &a, const vec2d &b, const vec2d &c, const vec2d &d) {
+	const auto adx = difference(a.x(), d.x()), ady = difference(a.y(), d.y());
+	const auto bdx = difference(b.x(), d.x()), bdy = difference(b.y(), d.y());
+	const auto cdx = difference(c.x(), d.x()), cdy = difference(c.y(), d.y());
+
+	const auto bc = bdx * cdy - cdx * bdy;
+	const auto ca = cdx * ady - adx * cdy;
+	const auto ab = adx * bdy - bdx * ady;
+	const auto al = adx * adx + ady * ady;
+	const auto bl = bdx * bdx + bdy * bdy;
+	const auto cl = cdx * cdx + cdy * cdy;
+	return (al * bc + bl * ca + cl * ab).sign();
+}
+
+void orient2d(
+	const vec2d &a,
+	const vec2d &b,
+	const vec2d *points,
+	int8_t *     res,
+	size_t       count) {
+	constexpr size_t W    = MaxLanes<double>;
+	const size_t     full = count - count % W;
+
+	auto packs = ALPHA4_SIMD_SELECT(orient2dPacks);
+
+	parallelFor(0, full / W, 2048, [&](size_t b0, size_t e0) {
+		packs(a, b, points, res, b0 * W, e0 * W);
+	});
+	for (size_t i = full; i < count; i++)
+		res[i] = int8_t(orient2d(a, b, points[i]));
+}
+
+void orient3d(
+	const vec3d &a,
+	const vec3d &b,
+	const vec3d &c,
+	const vec3d *points,
+	int8_t *     res,
+	size_t       count) {
+	constexpr size_t W    = MaxLanes<double>;
+	const size_t     full = count - count % W;
+
+	auto packs = ALPHA4_SIMD_SELECT(orient3dPacks);
+
+	parallelFor(0, full / W, 2048, [&](size_t b0, size_t e0) {
+		packs(a, b, c, points, res, b0 * W, e0 * W);
+	});
+	for (size_t i = full; i < count; i++)
+		res[i] = int8_t(orient3d(a, b, c, points[i]));
+}
+
+} // namespace alp
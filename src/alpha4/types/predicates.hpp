@@ -0,0 +1,113 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_PREDICATES_HPP
+#define ALPHA4_TYPES_PREDICATES_HPP
+#include "alpha4/types/vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace alp {
+
+// Robust geometric predicates after Shewchuk. All return the sign +1, -1 or 0
+// of a determinant, exactly for any finite input that does not underflow or
+// overflow. An error bound check on the plain double evaluation decides almost
+// all calls, only the remaining ones are evaluated with exact expansion
+// arithmetic by the *Exact variants.
+
+struct PredicateBounds {
+	static constexpr const double epsilon = 1.1102230246251565e-16; // 2^-53
+	static constexpr const double orient2d = (3 + 16 * epsilon) * epsilon;
+	static constexpr const double orient3d = (7 + 56 * epsilon) * epsilon;
+	static constexpr const double incircle = (10 + 96 * epsilon) * epsilon;
+};
+
+int orient2dExact(const vec2d &a, const vec2d &b, const vec2d &c);
+int orient3dExact(
+	const vec3d &a, const vec3d &b, const vec3d &c, const vec3d &d);
+int incircleExact(
+	const vec2d &a, const vec2d &b, const vec2d &c, const vec2d &d);
+
+// Positive if a, b, c are in counterclockwise order, zero if collinear.
+inline int orient2d(const vec2d &a, const vec2d &b, const vec2d &c) {
+	const double l   = (a.x() - c.x()) * (b.y() - c.y());
+	const double r   = (a.y() - c.y()) * (b.x() - c.x());
+	const double det = l - r;
+	const double err = PredicateBounds::orient2d * (std::abs(l) + std::abs(r));
+	if (det >= err || -det >= err) return (det > 0) - (det < 0);
+	return orient2dExact(a, b, c);
+}
+
+// Positive if d lies below the plane through a, b, c, where below is the side
+// from which a, b, c appear clockwise. Zero if coplanar.
+inline int
+	orient3d(const vec3d &a, const vec3d &b, const vec3d &c, const vec3d &d) {
+	const vec3d  ad = a - d, bd = b - d, cd = c - d;
+	const double bc = bd.x() * cd.y(), cb = cd.x() * bd.y();
+	const double ca = cd.x() * ad.y(), ac = ad.x() * cd.y();
+	const double ab = ad.x() * bd.y(), ba = bd.x() * ad.y();
+
+	const double det =
+		ad.z() * (bc - cb) + bd.z() * (ca - ac) + cd.z() * (ab - ba);
+	const double permanent = (std::abs(bc) + std::abs(cb)) * std::abs(ad.z())
+		+ (std::abs(ca) + std::abs(ac)) * std::abs(bd.z())
+		+ (std::abs(ab) + std::abs(ba)) * std::abs(cd.z());
+	const double err = PredicateBounds::orient3d * permanent;
+	if (det >= err || -det >= err) return (det > 0) - (det < 0);
+	return orient3dExact(a, b, c, d);
+}
+
+// Positive if d lies inside the circle through a, b, c, given in
+// counterclockwise order. Zero if the four points are cocircular.
+inline int
+	incircle(const vec2d &a, const vec2d &b, const vec2d &c, const vec2d &d) {
+	const vec2d  ad = a - d, bd = b - d, cd = c - d;
+	const double bc = bd.x() * cd.y(), cb = cd.x() * bd.y();
+	const double ca = cd.x() * ad.y(), ac = ad.x() * cd.y();
+	const double ab = ad.x() * bd.y(), ba = bd.x() * ad.y();
+	const double al = ad.x() * ad.x() + ad.y() * ad.y();
+	const double bl = bd.x() * bd.x() + bd.y() * bd.y();
+	const double cl = cd.x() * cd.x() + cd.y() * cd.y();
+
+	const double det = al * (bc - cb) + bl * (ca - ac) + cl * (ab - ba);
+	const double permanent = (std::abs(bc) + std::abs(cb)) * al
+		+ (std::abs(ca) + std::abs(ac)) * bl + (std::abs(ab) + std::abs(ba)) * cl;
+	const double err = PredicateBounds::incircle * permanent;
+	if (det >= err || -det >= err) return (det > 0) - (det < 0);
+	return incircleExact(a, b, c, d);
+}
+
+// Batch forms classifying many points against the edge a, b or the plane
+// through a, b, c. The filter runs on SIMD packs, points it cannot decide fall
+// back to the exact evaluation.
+void orient2d(
+	const vec2d &a,
+	const vec2d &b,
+	const vec2d *points,
+	int8_t *     res,
+	size_t       count);
+void orient3d(
+	const vec3d &a,
+	const vec3d &b,
+	const vec3d &c,
+	const vec3d *points,
+	int8_t *     res,
+	size_t       count);
+
+} // namespace alp
+#endif
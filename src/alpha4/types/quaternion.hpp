@@ -0,0 +1,195 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_QUATERNION_HPP
+#define ALPHA4_TYPES_QUATERNION_HPP
+#include "alpha4/types/affine.hpp"
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <cmath>
+
+namespace alp {
+
+// Quaternion w + xi + yj + zk, stored as (x, y, z, w).
+template<typename T> struct Quaternion : public Vector<4, T> {
+	using Vector<4, T>::Vector;
+	using Vector<4, T>::x;
+	using Vector<4, T>::y;
+	using Vector<4, T>::z;
+	using Vector<4, T>::w;
+
+	Quaternion() : Vector<4, T>(T(0), T(0), T(0), T(1)) {}
+	Quaternion(const Vector<4, T> &v) : Vector<4, T>(v) {}
+
+	static Quaternion AxisAngle(const Vector<3, T> &axis, T ang) {
+		const Vector<3, T> u = axis.normalized();
+		const T            s = T(std::sin(ang * T(0.5)));
+		const T            c = T(std::cos(ang * T(0.5)));
+		return Quaternion(u.x() * s, u.y() * s, u.z() * s, c);
+	}
+
+	// Rotation part of an orthonormal 3x3 block (Shepperd's method).
+	template<typename M> static Quaternion FromRotation(const M &m) {
+		const T tr = m.a11 + m.a22 + m.a33;
+		if (tr > 0) {
+			const T s = T(2) * std::sqrt(tr + 1);
+			return Quaternion(
+				(m.a32 - m.a23) / s, (m.a13 - m.a31) / s, (m.a21 - m.a12) / s, s / 4);
+		} else if (m.a11 > m.a22 && m.a11 > m.a33) {
+			const T s = T(2) * std::sqrt(1 + m.a11 - m.a22 - m.a33);
+			return Quaternion(
+				s / 4, (m.a12 + m.a21) / s, (m.a13 + m.a31) / s, (m.a32 - m.a23) / s);
+		} else if (m.a22 > m.a33) {
+			const T s = T(2) * std::sqrt(1 + m.a22 - m.a11 - m.a33);
+			return Quaternion(
+				(m.a12 + m.a21) / s, s / 4, (m.a23 + m.a32) / s, (m.a13 - m.a31) / s);
+		} else {
+			const T s = T(2) * std::sqrt(1 + m.a33 - m.a11 - m.a22);
+			return Quaternion(
+				(m.a13 + m.a31) / s, (m.a23 + m.a32) / s, s / 4, (m.a21 - m.a12) / s);
+		}
+	}
+
+	Quaternion operator*(const Quaternion &b) const {
+		const auto &a = *this;
+		return Quaternion(
+			a.w() * b.x() + a.x() * b.w() + a.y() * b.z() - a.z() * b.y(),
+			a.w() * b.y() - a.x() * b.z() + a.y() * b.w() + a.z() * b.x(),
+			a.w() * b.z() + a.x() * b.y() - a.y() * b.x() + a.z() * b.w(),
+			a.w() * b.w() - a.x() * b.x() - a.y() * b.y() - a.z() * b.z());
+	}
+	Quaternion operator*(T f) const {
+		return Quaternion(x() * f, y() * f, z() * f, w() * f);
+	}
+	Quaternion operator+(const Quaternion &b) const {
+		return Quaternion(x() + b.x(), y() + b.y(), z() + b.z(), w() + b.w());
+	}
+
+	T dot(const Quaternion &b) const {
+		return x() * b.x() + y() * b.y() + z() * b.z() + w() * b.w();
+	}
+
+	Quaternion conjugate() const { return Quaternion(-x(), -y(), -z(), w()); }
+	Quaternion normalized() const { return Vector<4, T>::normalized(); }
+
+	Vector<3, T> rotate(const Vector<3, T> &v) const {
+		// v + 2 q x (q x v + w v)
+		const Vector<3, T> q(x(), y(), z());
+		const Vector<3, T> t = (q % v) * T(2);
+		return v + t * w() + q % t;
+	}
+
+	// Shortest-path spherical interpolation.
+	static Quaternion Slerp(const Quaternion &a, Quaternion b, T t) {
+		T c = a.dot(b);
+		if (c < 0) {
+			b = b * T(-1);
+			c = -c;
+		}
+		if (c > T(0.9995)) return (a * (1 - t) + b * t).normalized();
+		const T ang = std::acos(c), s = std::sin(ang);
+		return a * (std::sin((1 - t) * ang) / s) + b * (std::sin(t * ang) / s);
+	}
+
+	template<matrix_storage_type_t stor = ROW_MAJOR>
+	Matrix4<T, stor> toMatrix() const {
+		const T xx = x() * x(), yy = y() * y(), zz = z() * z();
+		const T xy = x() * y(), xz = x() * z(), yz = y() * z();
+		const T wx = w() * x(), wy = w() * y(), wz = w() * z();
+		// clang-format off
+		return Matrix4<T, stor>(
+			1 - 2*(yy + zz), 2*(xy - wz),     2*(xz + wy),     0,
+			2*(xy + wz),     1 - 2*(xx + zz), 2*(yz - wx),     0,
+			2*(xz - wy),     2*(yz + wx),     1 - 2*(xx + yy), 0,
+			0,               0,               0,               1);
+		// clang-format on
+	}
+
+	Affine3<T> toAffine(const Vector<3, T> &t = Vector<3, T>()) const {
+		const T xx = x() * x(), yy = y() * y(), zz = z() * z();
+		const T xy = x() * y(), xz = x() * z(), yz = y() * z();
+		const T wx = w() * x(), wy = w() * y(), wz = w() * z();
+		// clang-format off
+		return Affine3<T>(
+			1 - 2*(yy + zz), 2*(xy - wz),     2*(xz + wy),     t.x(),
+			2*(xy + wz),     1 - 2*(xx + zz), 2*(yz - wx),     t.y(),
+			2*(xz - wy),     2*(yz + wx),     1 - 2*(xx + yy), t.z());
+		// clang-format on
+	}
+};
+
+// Rigid transformation as a unit dual quaternion real + eps * dual.
+template<typename T> struct DualQuaternion {
+	Quaternion<T> real;
+	Quaternion<T> dual = Quaternion<T>(T(0), T(0), T(0), T(0));
+
+	DualQuaternion() {}
+	DualQuaternion(const Quaternion<T> &real, const Quaternion<T> &dual) :
+		real(real), dual(dual) {}
+
+	static DualQuaternion RotationTranslation(
+		const Quaternion<T> &r, const Vector<3, T> &t) {
+		return DualQuaternion(
+			r, Quaternion<T>(t.x(), t.y(), t.z(), T(0)) * r * T(0.5));
+	}
+
+	// Rigid part of an affine transform. Scale, shear and mirroring are
+	// discarded by orthonormalizing the basis first, as FromRotation() expects.
+	static DualQuaternion FromAffine(const Affine3<T> &m) {
+		const Vector<3, T> x = Vector<3, T>(m.a11, m.a21, m.a31).normalized();
+		Vector<3, T>       y(m.a12, m.a22, m.a32);
+		y                    = (y - x * (x * y)).normalized();
+		const Vector<3, T> z = x % y;
+		// clang-format off
+		const Affine3<T> r(
+			x.x(), y.x(), z.x(), 0,
+			x.y(), y.y(), z.y(), 0,
+			x.z(), y.z(), z.z(), 0);
+		// clang-format on
+		return RotationTranslation(
+			Quaternion<T>::FromRotation(r).normalized(), m.translation());
+	}
+	template<matrix_storage_type_t stor>
+	static DualQuaternion FromMatrix(const Matrix4<T, stor> &m) {
+		return FromAffine(Affine3<T>::FromMatrix(m));
+	}
+
+	Vector<3, T> translation() const {
+		const Quaternion<T> t = dual * real.conjugate() * T(2);
+		return {t.x(), t.y(), t.z()};
+	}
+
+	Vector<3, T> operator*(const Vector<3, T> &p) const {
+		return real.rotate(p) + translation();
+	}
+
+	Affine3<T> toAffine() const { return real.toAffine(translation()); }
+};
+
+typedef Quaternion<float>      quatf;
+typedef Quaternion<double>     quatd;
+typedef DualQuaternion<float>  dquatf;
+typedef DualQuaternion<double> dquatd;
+
+} // namespace alp
+
+extern template struct alp::Quaternion<float>;
+extern template struct alp::Quaternion<double>;
+extern template struct alp::DualQuaternion<float>;
+extern template struct alp::DualQuaternion<double>;
+#endif
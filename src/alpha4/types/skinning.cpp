@@ -0,0 +1,305 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "skinning.hpp"
+
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/common/simd.hpp"
+#include "alpha4/types/quaternion.hpp"
+
+namespace alp {
+namespace {
+
+using namespace simd;
+
+// Palette entries are gathered per lane from a flat array of Stride scalars
+// per bone: the 3x4 affine block for linear blending, real and dual part
+// (x, y, z, w each) for dual quaternions.
+template<typename T, size_t Stride, size_t B> struct Gathered {
+	pack_t<T, B> v[Stride];
+
+	ALPHA4_SIMD_INLINE void load(const T *palette, const uint16_t *bones) {
+		T lanes[Stride][Lanes<T, B>];
+		for (size_t l = 0; l < Lanes<T, B>; l++) {
+			const T *src = palette + size_t(bones[l * 4]) * Stride;
+			for (size_t e = 0; e < Stride; e++)
+				lanes[e][l] = src[e];
+		}
+		for (size_t e = 0; e < Stride; e++)
+			v[e] = simd::load<T, B>(lanes[e]);
+	}
+};
+
+template<typename T, size_t B>
+ALPHA4_SIMD_INLINE void
+	normalize3(pack_t<T, B> &x, pack_t<T, B> &y, pack_t<T, B> &z) {
+	pack_t<T, B> n = x * x + y * y + z * z;
+	n              = n > 0 ? T(1) / simd::sqrt<T, B>(n) : pack_t<T, B>{};
+	x *= n;
+	y *= n;
+	z *= n;
+}
+
+template<typename T, size_t B>
+ALPHA4_SIMD_INLINE void skinLinear(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	size_t                    v,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	typedef pack_t<T, B> P;
+
+	P m[12] = {};
+	for (size_t k = 0; k < 4; k++) {
+		const P w = gather<T, B>(vtx.weights[v].data() + k, 4);
+		Gathered<T, 12, B> bone;
+		bone.load(palette, vtx.bones[v].data() + k);
+		for (size_t e = 0; e < 12; e++)
+			m[e] += w * bone.v[e];
+	}
+
+	const P px = gather<T, B>(vtx.positions[v].data() + 0, 3);
+	const P py = gather<T, B>(vtx.positions[v].data() + 1, 3);
+	const P pz = gather<T, B>(vtx.positions[v].data() + 2, 3);
+	scatter<T, B>(
+		outP[v].data() + 0, 3, m[0] * px + m[1] * py + m[2] * pz + m[3]);
+	scatter<T, B>(
+		outP[v].data() + 1, 3, m[4] * px + m[5] * py + m[6] * pz + m[7]);
+	scatter<T, B>(
+		outP[v].data() + 2, 3, m[8] * px + m[9] * py + m[10] * pz + m[11]);
+
+	if (outN) {
+		const P nx = gather<T, B>(vtx.normals[v].data() + 0, 3);
+		const P ny = gather<T, B>(vtx.normals[v].data() + 1, 3);
+		const P nz = gather<T, B>(vtx.normals[v].data() + 2, 3);
+		P       rx = m[0] * nx + m[1] * ny + m[2] * nz;
+		P       ry = m[4] * nx + m[5] * ny + m[6] * nz;
+		P       rz = m[8] * nx + m[9] * ny + m[10] * nz;
+		normalize3<T, B>(rx, ry, rz);
+		scatter<T, B>(outN[v].data() + 0, 3, rx);
+		scatter<T, B>(outN[v].data() + 1, 3, ry);
+		scatter<T, B>(outN[v].data() + 2, 3, rz);
+	}
+}
+
+// v + 2 q x (q x v + w v) for the unit quaternion (x, y, z, w)
+template<typename T, size_t B>
+ALPHA4_SIMD_INLINE void rotate(
+	const pack_t<T, B> *q, const pack_t<T, B> *v, pack_t<T, B> *r) {
+	typedef pack_t<T, B> P;
+	const P &x = q[0], &y = q[1], &z = q[2], &w = q[3];
+
+	const P cx = 2 * (y * v[2] - z * v[1]);
+	const P cy = 2 * (z * v[0] - x * v[2]);
+	const P cz = 2 * (x * v[1] - y * v[0]);
+	r[0]       = v[0] + w * cx + (y * cz - z * cy);
+	r[1]       = v[1] + w * cy + (z * cx - x * cz);
+	r[2]       = v[2] + w * cz + (x * cy - y * cx);
+}
+
+template<typename T, size_t B>
+ALPHA4_SIMD_INLINE void skinDual(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	size_t                    v,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	typedef pack_t<T, B> P;
+
+	P q[8] = {};
+	P r0[4];
+	for (size_t k = 0; k < 4; k++) {
+		P                 w = gather<T, B>(vtx.weights[v].data() + k, 4);
+		Gathered<T, 8, B> bone;
+		bone.load(palette, vtx.bones[v].data() + k);
+		if (k == 0) {
+			for (size_t e = 0; e < 4; e++)
+				r0[e] = bone.v[e];
+		} else {
+			// keep all influences in the hemisphere of the first one
+			const P d = r0[0] * bone.v[0] + r0[1] * bone.v[1] + r0[2] * bone.v[2]
+				+ r0[3] * bone.v[3];
+			w = d < 0 ? -w : w;
+		}
+		for (size_t e = 0; e < 8; e++)
+			q[e] += w * bone.v[e];
+	}
+
+	P n = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+	n   = n > 0 ? T(1) / simd::sqrt<T, B>(n) : P{};
+	for (size_t e = 0; e < 8; e++)
+		q[e] *= n;
+
+	const P &x = q[0], &y = q[1], &z = q[2], &w = q[3];
+	const P &dx = q[4], &dy = q[5], &dz = q[6], &dw = q[7];
+
+	// t = 2 * dual * conj(real)
+	const P tx = 2 * (dw * -x + dx * w + dy * -z - dz * -y);
+	const P ty = 2 * (dw * -y - dx * -z + dy * w + dz * -x);
+	const P tz = 2 * (dw * -z + dx * -y - dy * -x + dz * w);
+
+	P in[3], res[3];
+	for (size_t c = 0; c < 3; c++)
+		in[c] = gather<T, B>(vtx.positions[v].data() + c, 3);
+	rotate<T, B>(q, in, res);
+	scatter<T, B>(outP[v].data() + 0, 3, res[0] + tx);
+	scatter<T, B>(outP[v].data() + 1, 3, res[1] + ty);
+	scatter<T, B>(outP[v].data() + 2, 3, res[2] + tz);
+
+	if (outN) {
+		for (size_t c = 0; c < 3; c++)
+			in[c] = gather<T, B>(vtx.normals[v].data() + c, 3);
+		rotate<T, B>(q, in, res);
+		for (size_t c = 0; c < 3; c++)
+			scatter<T, B>(outN[v].data() + c, 3, res[c]);
+	}
+}
+
+template<typename T, SkinningMode Mode, size_t B>
+ALPHA4_SIMD_INLINE void skinPacks(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	size_t                    begin,
+	size_t                    end,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	for (size_t v = begin; v < end; v += Lanes<T, B>) {
+		if constexpr (Mode == SkinningMode::LinearBlend)
+			skinLinear<T, B>(vtx, palette, v, outP, outN);
+		else
+			skinDual<T, B>(vtx, palette, v, outP, outN);
+	}
+}
+
+template<typename T, SkinningMode Mode>
+void skinPacksGeneric(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	size_t                    begin,
+	size_t                    end,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	skinPacks<T, Mode, PackBytes<Isa::Generic>>(
+		vtx, palette, begin, end, outP, outN);
+}
+
+#ifdef ALPHA4_SIMD_X86
+template<typename T, SkinningMode Mode>
+ALPHA4_TARGET_AVX2 void skinPacksAVX2(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	size_t                    begin,
+	size_t                    end,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	skinPacks<T, Mode, PackBytes<Isa::AVX2>>(
+		vtx, palette, begin, end, outP, outN);
+}
+
+template<typename T, SkinningMode Mode>
+ALPHA4_TARGET_AVX512 void skinPacksAVX512(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	size_t                    begin,
+	size_t                    end,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	skinPacks<T, Mode, PackBytes<Isa::AVX512>>(
+		vtx, palette, begin, end, outP, outN);
+}
+#endif
+
+template<typename T, SkinningMode Mode>
+void skinAll(
+	const SkinnedVertices<T> &vtx,
+	const T *                 palette,
+	Vector<3, T> *            outP,
+	Vector<3, T> *            outN) {
+	constexpr size_t W    = MaxLanes<T>;
+	const size_t     full = vtx.count - vtx.count % W;
+
+	auto packs = ALPHA4_SIMD_SELECT(skinPacks, <T, Mode>);
+
+	parallelFor(0, full / W, 256, [&](size_t b, size_t e) {
+		packs(vtx, palette, b * W, e * W, outP, outN);
+	});
+
+	if (full < vtx.count) {
+		// run the tail through a padded copy
+		const size_t        n = vtx.count - full;
+		Vector<3, T>        p[W], nrm[W], rp[W], rn[W];
+		Vector<4, T>        w[W];
+		Vector<4, uint16_t> b[W];
+		for (size_t i = 0; i < n; i++) {
+			p[i] = vtx.positions[full + i];
+			if (outN) nrm[i] = vtx.normals[full + i];
+			w[i] = vtx.weights[full + i];
+			b[i] = vtx.bones[full + i];
+		}
+		SkinnedVertices<T> tail{p, nrm, w, b, W};
+		skinPacksGeneric<T, Mode>(tail, palette, 0, W, rp, outN ? rn : nullptr);
+		for (size_t i = 0; i < n; i++) {
+			outP[full + i] = rp[i];
+			if (outN) outN[full + i] = rn[i];
+		}
+	}
+}
+
+} // namespace
+
+template<typename T>
+void skin(
+	const SkinnedVertices<T> &vertices,
+	const Affine3<T> *        palette,
+	size_t                    paletteSize,
+	SkinningMode              mode,
+	Vector<3, T> *            positions,
+	Vector<3, T> *            normals) {
+	if (!vertices.normals) normals = nullptr;
+
+	if (mode == SkinningMode::LinearBlend) {
+		skinAll<T, SkinningMode::LinearBlend>(
+			vertices, &palette->a11, positions, normals);
+		return;
+	}
+
+	std::vector<T> dq(paletteSize * 8);
+	for (size_t i = 0; i < paletteSize; i++) {
+		const auto q = DualQuaternion<T>::FromAffine(palette[i]);
+		std::copy(q.real.begin(), q.real.end(), dq.begin() + i * 8);
+		std::copy(q.dual.begin(), q.dual.end(), dq.begin() + i * 8 + 4);
+	}
+	skinAll<T, SkinningMode::DualQuaternion>(
+		vertices, dq.data(), positions, normals);
+}
+
+template void skin<float>(
+	const SkinnedVertices<float> &,
+	const Affine3<float> *,
+	size_t,
+	SkinningMode,
+	Vector<3, float> *,
+	Vector<3, float> *);
+template void skin<double>(
+	const SkinnedVertices<double> &,
+	const Affine3<double> *,
+	size_t,
+	SkinningMode,
+	Vector<3, double> *,
+	Vector<3, double> *);
+
+} // namespace alp
@@ -0,0 +1,74 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_SKINNING_HPP
+#define ALPHA4_TYPES_SKINNING_HPP
+#include "alpha4/types/affine.hpp"
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace alp {
+
+// Bind pose of a mesh with up to four bone influences per vertex. Weights are
+// expected to sum up to one, unused influences carry a zero weight. Bone
+// indices must address the palette passed to skin(). normals may be null.
+template<typename T> struct SkinnedVertices {
+	const Vector<3, T> *       positions;
+	const Vector<3, T> *       normals;
+	const Vector<4, T> *       weights;
+	const Vector<4, uint16_t> *bones;
+	size_t                     count;
+};
+
+enum class SkinningMode {
+	// blends the bone matrices, may collapse volume around twisting joints
+	LinearBlend,
+	// blends the rigid part of each bone as dual quaternions, ignores scale
+	DualQuaternion,
+};
+
+// Transforms all vertices by the weighted bone palette. Normals are only
+// written if both the input and output normal arrays are given. Vertices are
+// processed in SIMD packs and split across threads.
+template<typename T>
+void skin(
+	const SkinnedVertices<T> &vertices,
+	const Affine3<T> *        palette,
+	size_t                    paletteSize,
+	SkinningMode              mode,
+	Vector<3, T> *            positions,
+	Vector<3, T> *            normals = nullptr);
+
+template<typename T, matrix_storage_type_t stor>
+void skin(
+	const SkinnedVertices<T> &vertices,
+	const Matrix4<T, stor> *  palette,
+	size_t                    paletteSize,
+	SkinningMode              mode,
+	Vector<3, T> *            positions,
+	Vector<3, T> *            normals = nullptr) {
+	std::vector<Affine3<T>> affine(paletteSize);
+	for (size_t i = 0; i < paletteSize; i++)
+		affine[i] = Affine3<T>::FromMatrix(palette[i]);
+	skin(vertices, affine.data(), paletteSize, mode, positions, normals);
+}
+
+} // namespace alp
+#endif
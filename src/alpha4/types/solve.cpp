@@ -0,0 +1,267 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "solve.hpp"
+
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace alp {
+namespace {
+
+using namespace simd;
+
+template<size_t N, typename T, size_t B>
+ALPHA4_SIMD_INLINE void kernelLU(
+	const T *a, const T *b, T *x, size_t stride, uint8_t *failed) {
+	typedef pack_t<T, B> P;
+	typedef mask_t<T, B> M;
+
+	P m[N][N], r[N];
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++)
+			m[i][j] = load<T, B>(a + (i * N + j) * stride);
+		r[i] = load<T, B>(b + i * stride);
+	}
+
+	M fail = M{} != M{};
+	P inv[N];
+	for (size_t c = 0; c < N; c++) {
+		// branchless pivoting: bubble the largest magnitude up to row c
+		for (size_t i = c + 1; i < N; i++) {
+			const M sel = simd::abs<T, B>(m[i][c]) > simd::abs<T, B>(m[c][c]);
+			for (size_t j = c; j < N; j++) {
+				const P t = m[c][j];
+				m[c][j]   = sel ? m[i][j] : t;
+				m[i][j]   = sel ? t : m[i][j];
+			}
+			const P t = r[c];
+			r[c]      = sel ? r[i] : t;
+			r[i]      = sel ? t : r[i];
+		}
+		const M zero = m[c][c] == 0;
+		fail |= zero;
+		inv[c] = T(1) / (zero ? P{} + T(1) : m[c][c]);
+
+		for (size_t i = c + 1; i < N; i++) {
+			const P f = m[i][c] * inv[c];
+			for (size_t j = c + 1; j < N; j++)
+				m[i][j] -= f * m[c][j];
+			r[i] -= f * r[c];
+		}
+	}
+
+	P s[N];
+	for (size_t i = N; i-- > 0;) {
+		P v = r[i];
+		for (size_t j = i + 1; j < N; j++)
+			v -= m[i][j] * s[j];
+		s[i] = v * inv[i];
+	}
+	for (size_t i = 0; i < N; i++) {
+		s[i] = fail ? P{} : s[i];
+		store<T, B>(x + i * stride, s[i]);
+	}
+	if (failed) {
+		for (size_t l = 0; l < Lanes<T, B>; l++)
+			failed[l] = fail[l] != 0;
+	}
+}
+
+template<size_t N, typename T, size_t B>
+ALPHA4_SIMD_INLINE void kernelCholesky(
+	const T *a, const T *b, T *x, size_t stride, uint8_t *failed) {
+	typedef pack_t<T, B> P;
+	typedef mask_t<T, B> M;
+
+	P l[N][N], inv[N];
+	M fail = M{} != M{};
+	for (size_t j = 0; j < N; j++) {
+		P d = load<T, B>(a + (j * N + j) * stride);
+		for (size_t k = 0; k < j; k++)
+			d -= l[j][k] * l[j][k];
+		const M bad = !(d > 0);
+		fail |= bad;
+		d = bad ? P{} + T(1) : d;
+		d       = simd::sqrt<T, B>(d);
+		l[j][j] = d;
+		inv[j]  = T(1) / d;
+		for (size_t i = j + 1; i < N; i++) {
+			P v = load<T, B>(a + (i * N + j) * stride);
+			for (size_t k = 0; k < j; k++)
+				v -= l[i][k] * l[j][k];
+			l[i][j] = v * inv[j];
+		}
+	}
+
+	P s[N];
+	for (size_t i = 0; i < N; i++) {
+		P v = load<T, B>(b + i * stride);
+		for (size_t k = 0; k < i; k++)
+			v -= l[i][k] * s[k];
+		s[i] = v * inv[i];
+	}
+	for (size_t i = N; i-- > 0;) {
+		P v = s[i];
+		for (size_t k = i + 1; k < N; k++)
+			v -= l[k][i] * s[k];
+		s[i] = v * inv[i];
+	}
+	for (size_t i = 0; i < N; i++) {
+		s[i] = fail ? P{} : s[i];
+		store<T, B>(x + i * stride, s[i]);
+	}
+	if (failed) {
+		for (size_t lane = 0; lane < Lanes<T, B>; lane++)
+			failed[lane] = fail[lane] != 0;
+	}
+}
+
+// Runs the kernel over full packs in [begin, end). end - begin must be a
+// multiple of the lane count.
+template<size_t N, typename T, bool Cholesky, size_t B>
+ALPHA4_SIMD_INLINE void solvePacks(
+	const LinearSystemArray<N, T> &sys,
+	size_t                         begin,
+	size_t                         end,
+	uint8_t *                      failed) {
+	for (size_t k = begin; k < end; k += Lanes<T, B>) {
+		if constexpr (Cholesky)
+			kernelCholesky<N, T, B>(
+				sys.a + k,
+				sys.b + k,
+				sys.x + k,
+				sys.stride,
+				failed ? failed + k : nullptr);
+		else
+			kernelLU<N, T, B>(
+				sys.a + k,
+				sys.b + k,
+				sys.x + k,
+				sys.stride,
+				failed ? failed + k : nullptr);
+	}
+}
+
+template<size_t N, typename T, bool Cholesky>
+void solvePacksGeneric(
+	const LinearSystemArray<N, T> &sys,
+	size_t                         begin,
+	size_t                         end,
+	uint8_t *                      failed) {
+	solvePacks<N, T, Cholesky, PackBytes<Isa::Generic>>(sys, begin, end, failed);
+}
+
+#ifdef ALPHA4_SIMD_X86
+template<size_t N, typename T, bool Cholesky>
+ALPHA4_TARGET_AVX2 void solvePacksAVX2(
+	const LinearSystemArray<N, T> &sys,
+	size_t                         begin,
+	size_t                         end,
+	uint8_t *                      failed) {
+	solvePacks<N, T, Cholesky, PackBytes<Isa::AVX2>>(sys, begin, end, failed);
+}
+
+template<size_t N, typename T, bool Cholesky>
+ALPHA4_TARGET_AVX512 void solvePacksAVX512(
+	const LinearSystemArray<N, T> &sys,
+	size_t                         begin,
+	size_t                         end,
+	uint8_t *                      failed) {
+	solvePacks<N, T, Cholesky, PackBytes<Isa::AVX512>>(sys, begin, end, failed);
+}
+#endif
+
+template<size_t N, typename T, bool Cholesky>
+size_t solveBatch(const LinearSystemArray<N, T> &sys, uint8_t *failed) {
+	constexpr size_t W    = MaxLanes<T>;
+	const size_t     full = sys.count - sys.count % W;
+
+	std::vector<uint8_t> ownFailed;
+	if (!failed) {
+		ownFailed.resize(sys.count);
+		failed = ownFailed.data();
+	}
+
+	auto packs = ALPHA4_SIMD_SELECT(solvePacks, <N, T, Cholesky>);
+
+	parallelFor(0, full / W, 1024, [&](size_t b, size_t e) {
+		packs(sys, b * W, e * W, failed);
+	});
+
+	if (full < sys.count) {
+		// pad the tail with identity systems
+		const size_t n = sys.count - full;
+		T            a[N * N * W] = {}, b[N * W] = {}, x[N * W];
+		uint8_t      f[W];
+		for (size_t i = 0; i < N; i++) {
+			for (size_t lane = 0; lane < W; lane++)
+				a[(i * N + i) * W + lane] = T(1);
+			for (size_t j = 0; j < N; j++) {
+				const T *src = sys.a + (i * N + j) * sys.stride + full;
+				for (size_t lane = 0; lane < n; lane++)
+					a[(i * N + j) * W + lane] = src[lane];
+			}
+			for (size_t lane = 0; lane < n; lane++)
+				b[i * W + lane] = sys.b[i * sys.stride + full + lane];
+		}
+		LinearSystemArray<N, T> tail{a, b, x, W, W};
+		solvePacksGeneric<N, T, Cholesky>(tail, 0, W, f);
+		for (size_t i = 0; i < N; i++)
+			for (size_t lane = 0; lane < n; lane++)
+				sys.x[i * sys.stride + full + lane] = x[i * W + lane];
+		for (size_t lane = 0; lane < n; lane++)
+			failed[full + lane] = f[lane];
+	}
+
+	size_t res = 0;
+	for (size_t k = 0; k < sys.count; k++)
+		res += failed[k] ? 1 : 0;
+	return res;
+}
+
+} // namespace
+
+template<size_t N, typename T>
+size_t solveLU(const LinearSystemArray<N, T> &sys, uint8_t *failed) {
+	return solveBatch<N, T, false>(sys, failed);
+}
+template<size_t N, typename T>
+size_t solveCholesky(const LinearSystemArray<N, T> &sys, uint8_t *failed) {
+	return solveBatch<N, T, true>(sys, failed);
+}
+
+#define ALPHA4_SOLVE_INSTANTIATE(N, T)                                      \
+	template struct LUDecomposition<N, T>;                                    \
+	template struct CholeskyDecomposition<N, T>;                              \
+	template size_t solveLU<N, T>(const LinearSystemArray<N, T> &, uint8_t *); \
+	template size_t solveCholesky<N, T>(                                      \
+		const LinearSystemArray<N, T> &, uint8_t *);
+
+ALPHA4_SOLVE_INSTANTIATE(2, float)
+ALPHA4_SOLVE_INSTANTIATE(3, float)
+ALPHA4_SOLVE_INSTANTIATE(4, float)
+ALPHA4_SOLVE_INSTANTIATE(2, double)
+ALPHA4_SOLVE_INSTANTIATE(3, double)
+ALPHA4_SOLVE_INSTANTIATE(4, double)
+
+#undef ALPHA4_SOLVE_INSTANTIATE
+
+} // namespace alp
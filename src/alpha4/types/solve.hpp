@@ -0,0 +1,185 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_SOLVE_HPP
+#define ALPHA4_TYPES_SOLVE_HPP
+#include "alpha4/types/matrix.hpp"
+#include "alpha4/types/vector.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace alp {
+
+// Dense N x N matrix as an array of rows.
+template<size_t N, typename T>
+using SquareMatrix = std::array<Vector<N, T>, N>;
+
+template<typename T, matrix_storage_type_t stor>
+SquareMatrix<4, T> toSquareMatrix(const Matrix4<T, stor> &m) {
+	return {m.row1(), m.row2(), m.row3(), m.row4()};
+}
+
+// LU decomposition with partial pivoting, P A = L U. L has an implicit unit
+// diagonal and shares storage with U.
+template<size_t N, typename T> struct LUDecomposition {
+	SquareMatrix<N, T>       lu;
+	std::array<unsigned, N> perm;
+	bool                     valid = true;
+	bool                     odd   = false;
+
+	LUDecomposition(const SquareMatrix<N, T> &a) : lu(a) {
+		for (unsigned i = 0; i < N; i++)
+			perm[i] = i;
+
+		for (unsigned c = 0; c < N; c++) {
+			unsigned p = c;
+			for (unsigned i = c + 1; i < N; i++)
+				if (std::abs(lu[i][c]) > std::abs(lu[p][c])) p = i;
+			if (p != c) {
+				std::swap(lu[p], lu[c]);
+				std::swap(perm[p], perm[c]);
+				odd = !odd;
+			}
+			if (lu[c][c] == 0) {
+				valid = false;
+				continue;
+			}
+			const T inv = T(1) / lu[c][c];
+			for (unsigned i = c + 1; i < N; i++) {
+				const T f = (lu[i][c] *= inv);
+				for (unsigned j = c + 1; j < N; j++)
+					lu[i][j] -= f * lu[c][j];
+			}
+		}
+	}
+	template<matrix_storage_type_t stor>
+	LUDecomposition(const Matrix4<T, stor> &m) requires(N == 4) :
+		LUDecomposition(toSquareMatrix(m)) {}
+
+	// Returns a zero vector if the matrix is singular.
+	Vector<N, T> solve(const Vector<N, T> &b) const {
+		Vector<N, T> x;
+		if (!valid) return x;
+		for (unsigned i = 0; i < N; i++) {
+			T s = b[perm[i]];
+			for (unsigned j = 0; j < i; j++)
+				s -= lu[i][j] * x[j];
+			x[i] = s;
+		}
+		for (unsigned i = N; i-- > 0;) {
+			T s = x[i];
+			for (unsigned j = i + 1; j < N; j++)
+				s -= lu[i][j] * x[j];
+			x[i] = s / lu[i][i];
+		}
+		return x;
+	}
+
+	T det() const {
+		T d = odd ? T(-1) : T(1);
+		for (unsigned i = 0; i < N; i++)
+			d *= lu[i][i];
+		return d;
+	}
+};
+
+// Cholesky decomposition A = L L^T of a symmetric positive definite matrix.
+// Only the lower triangle of A is read.
+template<size_t N, typename T> struct CholeskyDecomposition {
+	SquareMatrix<N, T> l;
+	bool               valid = true;
+
+	CholeskyDecomposition(const SquareMatrix<N, T> &a) {
+		for (unsigned j = 0; j < N; j++) {
+			T d = a[j][j];
+			for (unsigned k = 0; k < j; k++)
+				d -= l[j][k] * l[j][k];
+			if (!(d > 0)) {
+				valid = false;
+				return;
+			}
+			l[j][j]     = std::sqrt(d);
+			const T inv = T(1) / l[j][j];
+			for (unsigned i = j + 1; i < N; i++) {
+				T s = a[i][j];
+				for (unsigned k = 0; k < j; k++)
+					s -= l[i][k] * l[j][k];
+				l[i][j] = s * inv;
+			}
+		}
+	}
+	template<matrix_storage_type_t stor>
+	CholeskyDecomposition(const Matrix4<T, stor> &m) requires(N == 4) :
+		CholeskyDecomposition(toSquareMatrix(m)) {}
+
+	// Returns a zero vector if the matrix is not positive definite.
+	Vector<N, T> solve(const Vector<N, T> &b) const {
+		Vector<N, T> x;
+		if (!valid) return x;
+		for (unsigned i = 0; i < N; i++) {
+			T s = b[i];
+			for (unsigned k = 0; k < i; k++)
+				s -= l[i][k] * x[k];
+			x[i] = s / l[i][i];
+		}
+		for (unsigned i = N; i-- > 0;) {
+			T s = x[i];
+			for (unsigned k = i + 1; k < N; k++)
+				s -= l[k][i] * x[k];
+			x[i] = s / l[i][i];
+		}
+		return x;
+	}
+};
+
+// Batch of independent systems A x = b in structure-of-arrays layout. Element
+// (i, j) of system k is a[(i * N + j) * stride + k], component i of its right
+// hand side and solution are b[i * stride + k] and x[i * stride + k].
+template<size_t N, typename T> struct LinearSystemArray {
+	const T *a;
+	const T *b;
+	T *      x;
+	size_t   count;
+	size_t   stride;
+};
+
+// Solve all systems of a batch, vectorized across systems. Failed systems
+// (singular, or not positive definite for Cholesky) get a zero solution and a
+// nonzero entry in failed if given. Returns the number of failed systems.
+template<size_t N, typename T>
+size_t solveLU(const LinearSystemArray<N, T> &sys, uint8_t *failed = nullptr);
+template<size_t N, typename T>
+size_t
+solveCholesky(const LinearSystemArray<N, T> &sys, uint8_t *failed = nullptr);
+
+} // namespace alp
+
+extern template struct alp::LUDecomposition<2, float>;
+extern template struct alp::LUDecomposition<3, float>;
+extern template struct alp::LUDecomposition<4, float>;
+extern template struct alp::LUDecomposition<2, double>;
+extern template struct alp::LUDecomposition<3, double>;
+extern template struct alp::LUDecomposition<4, double>;
+extern template struct alp::CholeskyDecomposition<2, float>;
+extern template struct alp::CholeskyDecomposition<3, float>;
+extern template struct alp::CholeskyDecomposition<4, float>;
+extern template struct alp::CholeskyDecomposition<2, double>;
+extern template struct alp::CholeskyDecomposition<3, double>;
+extern template struct alp::CholeskyDecomposition<4, double>;
+#endif
@@ -0,0 +1,228 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "spline.hpp"
+
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/common/simd.hpp"
+
+#include <cmath>
+#include <type_traits>
+
+namespace alp {
+namespace {
+
+using namespace simd;
+
+// Evaluates the spline, or its derivative, for Lanes<T, B> parameters at
+// once. Every lane gathers the coefficients of its own segment.
+template<size_t D, typename T, bool Derivative, size_t B>
+ALPHA4_SIMD_INLINE void evaluatePack(
+	const T *coefficients, size_t segments, const T *u, Vector<D, T> *res) {
+	typedef pack_t<T, B>               P;
+	typedef typename Pack<T, B>::index I;
+
+	P x = load<T, B>(u);
+	x   = x > 0 ? x : P{};
+	x   = x < T(segments) ? x : P{} + T(segments);
+
+	typedef std::remove_reference_t<decltype(I{}[0])> Int;
+
+	const Int last = Int(segments - 1);
+	I         s    = __builtin_convertvector(x, I);
+	s              = s < last ? s : I{} + last;
+
+	const P t = x - __builtin_convertvector(s, P);
+	for (size_t d = 0; d < D; d++) {
+		T lanes[4][Lanes<T, B>];
+		for (size_t l = 0; l < Lanes<T, B>; l++) {
+			const T *src = coefficients + (size_t(s[l]) * D + d) * 4;
+			for (size_t k = 0; k < 4; k++)
+				lanes[k][l] = src[k];
+		}
+		P c[4];
+		for (size_t k = 0; k < 4; k++)
+			c[k] = load<T, B>(lanes[k]);
+		P v;
+		if constexpr (Derivative)
+			v = (3 * c[3] * t + 2 * c[2]) * t + c[1];
+		else
+			v = ((c[3] * t + c[2]) * t + c[1]) * t + c[0];
+		scatter<T, B>(res[0].data() + d, D, v);
+	}
+}
+
+template<size_t D, typename T, bool Derivative, size_t B>
+ALPHA4_SIMD_INLINE void evaluatePacks(
+	const T *     coefficients,
+	size_t        segments,
+	const T *     u,
+	Vector<D, T> *res,
+	size_t        begin,
+	size_t        end) {
+	for (size_t i = begin; i < end; i += Lanes<T, B>)
+		evaluatePack<D, T, Derivative, B>(coefficients, segments, u + i, res + i);
+}
+
+template<size_t D, typename T, bool Derivative>
+void evaluatePacksGeneric(
+	const T *     coefficients,
+	size_t        segments,
+	const T *     u,
+	Vector<D, T> *res,
+	size_t        begin,
+	size_t        end) {
+	evaluatePacks<D, T, Derivative, PackBytes<Isa::Generic>>(
+		coefficients, segments, u, res, begin, end);
+}
+
+#ifdef ALPHA4_SIMD_X86
+template<size_t D, typename T, bool Derivative>
+ALPHA4_TARGET_AVX2 void evaluatePacksAVX2(
+	const T *     coefficients,
+	size_t        segments,
+	const T *     u,
+	Vector<D, T> *res,
+	size_t        begin,
+	size_t        end) {
+	evaluatePacks<D, T, Derivative, PackBytes<Isa::AVX2>>(
+		coefficients, segments, u, res, begin, end);
+}
+
+template<size_t D, typename T, bool Derivative>
+ALPHA4_TARGET_AVX512 void evaluatePacksAVX512(
+	const T *     coefficients,
+	size_t        segments,
+	const T *     u,
+	Vector<D, T> *res,
+	size_t        begin,
+	size_t        end) {
+	evaluatePacks<D, T, Derivative, PackBytes<Isa::AVX512>>(
+		coefficients, segments, u, res, begin, end);
+}
+#endif
+
+template<size_t D, typename T, bool Derivative>
+void evaluateAll(
+	const Spline<Vector<D, T>> &spline,
+	const T *                   coefficients,
+	const T *                   u,
+	Vector<D, T> *              res,
+	size_t                      count) {
+	constexpr size_t W    = MaxLanes<T>;
+	const size_t     full = count - count % W;
+	const size_t     segs = spline.segments();
+
+	auto packs = ALPHA4_SIMD_SELECT(evaluatePacks, <D, T, Derivative>);
+
+	parallelFor(0, full / W, 1024, [&](size_t b, size_t e) {
+		packs(coefficients, segs, u, res, b * W, e * W);
+	});
+
+	for (size_t i = full; i < count; i++)
+		res[i] = Derivative ? spline.derivative(u[i]) : spline.evaluate(u[i]);
+}
+
+} // namespace
+
+template<VectorType V>
+void Spline<V>::evaluate(const T *u, V *res, size_t count) const {
+	if (_segments == 0) {
+		std::fill(res, res + count, evaluate(T(0)));
+		return;
+	}
+	evaluateAll<D, T, false>(*this, _coefficients.data(), u, res, count);
+}
+
+template<VectorType V>
+void Spline<V>::derivative(const T *u, V *res, size_t count) const {
+	if (_segments == 0) {
+		std::fill(res, res + count, V());
+		return;
+	}
+	evaluateAll<D, T, true>(*this, _coefficients.data(), u, res, count);
+}
+
+template<VectorType V>
+void Spline<V>::buildArcLengthTable(size_t samplesPerSegment) {
+	// 5 point Gauss-Legendre nodes and weights on [-1, 1]
+	static const T x[5] = {
+		T(-0.9061798459386640),
+		T(-0.5384693101056831),
+		T(0),
+		T(0.5384693101056831),
+		T(0.9061798459386640)};
+	static const T w[5] = {
+		T(0.2369268850561891),
+		T(0.4786286704993665),
+		T(0.5688888888888889),
+		T(0.4786286704993665),
+		T(0.2369268850561891)};
+
+	_arcSamples = std::max<size_t>(samplesPerSegment, 1);
+	const size_t n = _segments * _arcSamples;
+	_arcLength.assign(n + 1, T(0));
+	if (n == 0) return;
+
+	const T h = T(1) / T(_arcSamples);
+	parallelFor(0, n, 4096, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++) {
+			const T mid = (T(i) + T(0.5)) * h;
+			T       len = 0;
+			for (size_t q = 0; q < 5; q++)
+				len += w[q] * derivative(mid + x[q] * h / 2).norm();
+			_arcLength[i + 1] = len * h / 2;
+		}
+	});
+	for (size_t i = 0; i < n; i++)
+		_arcLength[i + 1] += _arcLength[i];
+}
+
+template<VectorType V>
+void Spline<V>::parametersAtLength(const T *s, T *u, size_t count) const {
+	parallelFor(0, count, 4096, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			u[i] = parameterAtLength(s[i]);
+	});
+}
+
+template<VectorType V>
+void Spline<V>::tessellate(V *res, size_t count, bool byLength) const {
+	if (count == 0) return;
+
+	std::vector<T> u(count);
+	const T        step = count > 1 ? T(1) / T(count - 1) : T(0);
+	if (byLength && hasArcLengthTable()) {
+		for (size_t i = 0; i < count; i++)
+			u[i] = length() * T(i) * step;
+		parametersAtLength(u.data(), u.data(), count);
+	} else {
+		for (size_t i = 0; i < count; i++)
+			u[i] = T(_segments) * T(i) * step;
+	}
+	evaluate(u.data(), res, count);
+}
+
+} // namespace alp
+
+template class alp::Spline<alp::Vector<2, float>>;
+template class alp::Spline<alp::Vector<3, float>>;
+template class alp::Spline<alp::Vector<4, float>>;
+template class alp::Spline<alp::Vector<2, double>>;
+template class alp::Spline<alp::Vector<3, double>>;
+template class alp::Spline<alp::Vector<4, double>>;
@@ -0,0 +1,195 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_SPLINE_HPP
+#define ALPHA4_TYPES_SPLINE_HPP
+#include "alpha4/types/vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace alp {
+
+enum class SplineBasis : uint8_t { Bezier, CatmullRom, BSpline };
+
+// Piecewise cubic curve over control points of type V = Vector<D, Scalar>.
+//
+// Bezier splines use 3n + 1 points with shared end points, Catmull-Rom and
+// uniform B-splines n + 3 points, for n segments. The parameter u runs from 0
+// to segments(), each unit covering one segment, and is clamped to that range.
+// The basis matrix is applied to the control points up front, so every segment
+// is stored as power basis coefficients and evaluates with Horner's scheme.
+template<VectorType V> class Spline {
+public:
+	typedef typename V::Scalar    T;
+	static constexpr const size_t D = V::D;
+
+protected:
+	SplineBasis    _basis;
+	std::vector<V> _points;
+	size_t         _segments = 0;
+
+	// per segment and component the coefficients of 1, t, t^2, t^3
+	std::vector<T> _coefficients;
+
+	// cumulative arc length at samplesPerSegment steps per segment
+	std::vector<T> _arcLength;
+	size_t         _arcSamples = 0;
+
+	static const T *basisMatrix(SplineBasis basis) {
+		// clang-format off
+		static const T bezier[16] = {
+			 1,  0,  0, 0,
+			-3,  3,  0, 0,
+			 3, -6,  3, 0,
+			-1,  3, -3, 1};
+		static const T catmullRom[16] = {
+			 0,      1,    0,      0,
+			-0.5,    0,    0.5,    0,
+			 1,   -2.5,    2,   -0.5,
+			-0.5,  1.5, -1.5,    0.5};
+		static const T bSpline[16] = {
+			 T(1) / 6, T(4) / 6, T(1) / 6, 0,
+			-0.5,      0,        0.5,      0,
+			 0.5,     -1,        0.5,      0,
+			-T(1) / 6, 0.5,     -0.5,      T(1) / 6};
+		// clang-format on
+		switch (basis) {
+			case SplineBasis::Bezier: return bezier;
+			case SplineBasis::CatmullRom: return catmullRom;
+			default: return bSpline;
+		}
+	}
+
+	void computeCoefficients() {
+		const size_t n = _points.size();
+		if (n < 4)
+			_segments = 0;
+		else if (_basis == SplineBasis::Bezier)
+			_segments = (n - 1) / 3;
+		else
+			_segments = n - 3;
+
+		const T *m = basisMatrix(_basis);
+		_coefficients.assign(_segments * D * 4, T(0));
+		for (size_t s = 0; s < _segments; s++) {
+			const V *p = _points.data() + (_basis == SplineBasis::Bezier ? 3 * s : s);
+			T *      c = _coefficients.data() + s * D * 4;
+			for (size_t d = 0; d < D; d++) {
+				for (size_t k = 0; k < 4; k++) {
+					for (size_t j = 0; j < 4; j++)
+						c[d * 4 + k] += m[k * 4 + j] * p[j][d];
+				}
+			}
+		}
+		_arcLength.clear();
+		_arcSamples = 0;
+	}
+
+	// Segment coefficients and local parameter of u.
+	const T *locate(T u, T &t) const {
+		u              = std::clamp(u, T(0), T(_segments));
+		const size_t s = std::min(size_t(u), _segments - 1);
+		t              = u - T(s);
+		return _coefficients.data() + s * D * 4;
+	}
+
+public:
+	Spline(SplineBasis basis = SplineBasis::CatmullRom) : _basis(basis) {}
+	Spline(SplineBasis basis, const V *points, size_t count) : _basis(basis) {
+		setControlPoints(points, count);
+	}
+
+	void setControlPoints(const V *points, size_t count) {
+		_points.assign(points, points + count);
+		computeCoefficients();
+	}
+	void setBasis(SplineBasis basis) {
+		_basis = basis;
+		computeCoefficients();
+	}
+
+	SplineBasis           basis() const { return _basis; }
+	const std::vector<V> &controlPoints() const { return _points; }
+	size_t                segments() const { return _segments; }
+
+	V evaluate(T u) const {
+		if (_segments == 0) return _points.empty() ? V() : _points[0];
+		T        t;
+		const T *c = locate(u, t);
+		V        res;
+		for (size_t d = 0; d < D; d++, c += 4)
+			res[d] = ((c[3] * t + c[2]) * t + c[1]) * t + c[0];
+		return res;
+	}
+
+	// First derivative with respect to u.
+	V derivative(T u) const {
+		if (_segments == 0) return V();
+		T        t;
+		const T *c = locate(u, t);
+		V        res;
+		for (size_t d = 0; d < D; d++, c += 4)
+			res[d] = (3 * c[3] * t + 2 * c[2]) * t + c[1];
+		return res;
+	}
+
+	// Batch forms, vectorized over the parameters.
+	void evaluate(const T *u, V *res, size_t count) const;
+	void derivative(const T *u, V *res, size_t count) const;
+
+	// Tabulates the arc length, integrating the speed with Gauss-Legendre
+	// quadrature over samplesPerSegment intervals per segment. Invalidated by
+	// changing the control points or basis.
+	void buildArcLengthTable(size_t samplesPerSegment = 16);
+
+	bool hasArcLengthTable() const { return !_arcLength.empty(); }
+	T    length() const { return _arcLength.empty() ? T(0) : _arcLength.back(); }
+
+	// Parameter at arc length s, interpolated linearly from the table.
+	T parameterAtLength(T s) const {
+		if (_arcLength.size() < 2) return T(0);
+		const size_t i = std::min(
+			size_t(std::upper_bound(_arcLength.begin() + 1, _arcLength.end(), s)
+						 - _arcLength.begin()),
+			_arcLength.size() - 1);
+		const T a = _arcLength[i - 1], b = _arcLength[i];
+		const T f = b > a ? std::clamp((s - a) / (b - a), T(0), T(1)) : T(0);
+		return (T(i - 1) + f) / T(_arcSamples);
+	}
+	void parametersAtLength(const T *s, T *u, size_t count) const;
+
+	// Evaluates count points evenly spaced in parameter, or in arc length if
+	// byLength is set and the arc length table has been built.
+	void tessellate(V *res, size_t count, bool byLength = false) const;
+};
+
+typedef Spline<Vector<2, float>>  spline2f;
+typedef Spline<Vector<3, float>>  spline3f;
+typedef Spline<Vector<2, double>> spline2d;
+typedef Spline<Vector<3, double>> spline3d;
+
+} // namespace alp
+
+extern template class alp::Spline<alp::Vector<2, float>>;
+extern template class alp::Spline<alp::Vector<3, float>>;
+extern template class alp::Spline<alp::Vector<4, float>>;
+extern template class alp::Spline<alp::Vector<2, double>>;
+extern template class alp::Spline<alp::Vector<3, double>>;
+extern template class alp::Spline<alp::Vector<4, double>>;
+#endif
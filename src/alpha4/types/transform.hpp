@@ -0,0 +1,327 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4_TYPES_TRANSFORM_HPP
+#define ALPHA4_TYPES_TRANSFORM_HPP
+#include "alpha4/common/parallel.hpp"
+#include "alpha4/types/matrix.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace alp {
+
+// Scene graph of local transforms whose world matrices are propagated lazily.
+//
+// Nodes are addressed by the stable handle returned from add(). Internally all
+// per-node data lives in flat arrays ordered breadth-first, so every tree level
+// is a contiguous slot range and the children of a node are contiguous within
+// the next level. update() only visits nodes whose local transform changed and
+// their descendants, processing one level at a time and spreading each level
+// across threads.
+template<typename T, matrix_storage_type_t stor = ROW_MAJOR>
+class TransformHierarchy {
+public:
+	typedef Matrix4<T, stor> Matrix;
+	typedef size_t           Node;
+
+	static constexpr const Node   None  = Node(-1);
+	static constexpr const size_t Grain = 512;
+
+protected:
+	// per node handle, in insertion order
+	std::vector<Node>   _parentOf;
+	std::vector<size_t> _slotOf;
+
+	// per slot, breadth-first order
+	std::vector<Node>     _node;
+	std::vector<size_t>   _parent;
+	std::vector<size_t>   _firstChild;
+	std::vector<size_t>   _childCount;
+	std::vector<Matrix>   _local;
+	std::vector<Matrix>   _world;
+	std::vector<Matrix>   _inverse;
+	std::vector<uint8_t>  _queued;
+	std::vector<size_t>   _levelBegin;
+	std::vector<uint32_t> _depth;
+
+	std::vector<size_t> _dirty;
+	std::vector<size_t> _frontier, _next;
+
+	bool _structureDirty = false;
+	bool _cacheInverses  = false;
+
+	void markDirty(size_t slot) {
+		if (_queued[slot]) return;
+		_queued[slot] = 1;
+		_dirty.push_back(slot);
+	}
+
+	void rebuild() {
+		const size_t n = _parentOf.size();
+
+		std::vector<Matrix> byNode(n);
+		for (Node i = 0; i < n; i++)
+			byNode[i] = _local[_slotOf[i]];
+
+		// children of every handle, grouped by counting sort on the parent
+		std::vector<size_t> childBegin(n + 1, 0), children(n);
+		for (Node i = 0; i < n; i++)
+			if (_parentOf[i] != None) childBegin[_parentOf[i] + 1]++;
+		for (size_t i = 0; i < n; i++)
+			childBegin[i + 1] += childBegin[i];
+		{
+			std::vector<size_t> fill(childBegin.begin(), childBegin.end() - 1);
+			for (Node i = 0; i < n; i++)
+				if (_parentOf[i] != None) children[fill[_parentOf[i]]++] = i;
+		}
+
+		_node.clear();
+		_node.reserve(n);
+		_levelBegin.assign(1, 0);
+		for (Node i = 0; i < n; i++)
+			if (_parentOf[i] == None) _node.push_back(i);
+
+		for (size_t levelBegin = 0; levelBegin < _node.size();) {
+			const size_t levelEnd = _node.size();
+			_levelBegin.push_back(levelEnd);
+			for (size_t s = levelBegin; s < levelEnd; s++) {
+				const Node i = _node[s];
+				for (size_t c = childBegin[i]; c < childBegin[i + 1]; c++)
+					_node.push_back(children[c]);
+			}
+			levelBegin = levelEnd;
+		}
+
+		_slotOf.resize(n);
+		for (size_t s = 0; s < n; s++)
+			_slotOf[_node[s]] = s;
+
+		_parent.resize(n);
+		_firstChild.resize(n);
+		_childCount.resize(n);
+		_depth.resize(n);
+		_local.resize(n);
+		_world.resize(n);
+		_queued.assign(n, 0);
+
+		for (size_t level = 0; level + 1 < _levelBegin.size(); level++) {
+			for (size_t s = _levelBegin[level]; s < _levelBegin[level + 1]; s++)
+				_depth[s] = uint32_t(level);
+		}
+
+		size_t nextChild = rootCount();
+		for (size_t s = 0; s < n; s++) {
+			const Node i     = _node[s];
+			_parent[s]       = (_parentOf[i] == None) ? None : _slotOf[_parentOf[i]];
+			_local[s]        = byNode[i];
+			_childCount[s]   = childBegin[i + 1] - childBegin[i];
+			_firstChild[s]   = nextChild;
+			nextChild       += _childCount[s];
+		}
+
+		if (_cacheInverses) _inverse.resize(n);
+
+		// structural changes are rare, recompute everything once
+		_dirty.clear();
+		_structureDirty = false;
+		markRoots();
+	}
+
+	size_t rootCount() const {
+		return _levelBegin.size() > 1 ? _levelBegin[1] : 0;
+	}
+	void markRoots() {
+		for (size_t s = 0; s < rootCount(); s++)
+			markDirty(s);
+	}
+
+	void computeSlots(const std::vector<size_t> &slots) {
+		auto kernel = [this, &slots](size_t b, size_t e) {
+			for (size_t i = b; i < e; i++) {
+				const size_t s = slots[i];
+				if (_parent[s] == None)
+					_world[s] = _local[s];
+				else
+					_world[s] = _world[_parent[s]] * _local[s];
+				if (_cacheInverses) _inverse[s] = _world[s].inverse();
+				_queued[s] = 0;
+			}
+		};
+		parallelFor(0, slots.size(), Grain, kernel);
+	}
+
+public:
+	TransformHierarchy() {}
+
+	size_t size() const { return _parentOf.size(); }
+	bool   empty() const { return _parentOf.empty(); }
+
+	void reserve(size_t n) {
+		_parentOf.reserve(n);
+		_slotOf.reserve(n);
+		_local.reserve(n);
+	}
+
+	void clear() {
+		_parentOf.clear();
+		_slotOf.clear();
+		_node.clear();
+		_parent.clear();
+		_firstChild.clear();
+		_childCount.clear();
+		_local.clear();
+		_world.clear();
+		_inverse.clear();
+		_queued.clear();
+		_levelBegin.clear();
+		_depth.clear();
+		_dirty.clear();
+		_structureDirty = false;
+	}
+
+	// Appends a node below parent, or a new root if parent is None. Parents must
+	// be added before their children, so unknown parents also yield a root.
+	Node add(const Matrix &local = Matrix(), Node parent = None) {
+		const Node id = _parentOf.size();
+		if (parent != None && parent >= id) parent = None;
+
+		if (!_structureDirty) {
+			// slot order is kept as insertion order until the next rebuild
+			std::vector<Matrix> byNode(id);
+			for (Node i = 0; i < id; i++)
+				byNode[i] = _local[_slotOf[i]];
+			_local = std::move(byNode);
+			for (Node i = 0; i < id; i++)
+				_slotOf[i] = i;
+			_structureDirty = true;
+		}
+
+		_parentOf.push_back(parent);
+		_slotOf.push_back(id);
+		_local.push_back(local);
+		return id;
+	}
+
+	Node parent(Node n) const { return _parentOf[n]; }
+
+	uint32_t depth(Node n) {
+		if (_structureDirty) rebuild();
+		return _depth[_slotOf[n]];
+	}
+	size_t levels() {
+		if (_structureDirty) rebuild();
+		return _levelBegin.empty() ? 0 : _levelBegin.size() - 1;
+	}
+
+	const Matrix &local(Node n) const { return _local[_slotOf[n]]; }
+
+	void setLocal(Node n, const Matrix &m) {
+		_local[_slotOf[n]] = m;
+		if (!_structureDirty) markDirty(_slotOf[n]);
+	}
+
+	// Enables or disables maintaining inverse world matrices alongside the world
+	// matrices. Enabling recomputes all of them on the next update.
+	void setCacheInverses(bool enable) {
+		if (enable == _cacheInverses) return;
+		_cacheInverses = enable;
+		if (!enable) {
+			_inverse.clear();
+			_inverse.shrink_to_fit();
+		} else if (!_structureDirty) {
+			_inverse.resize(_node.size());
+			markRoots();
+		}
+	}
+	bool cacheInverses() const { return _cacheInverses; }
+
+	bool dirty() const { return _structureDirty || !_dirty.empty(); }
+
+	// Recomputes the world matrices of all nodes whose local transform changed
+	// since the last update, including their descendants.
+	void update() {
+		if (_structureDirty) rebuild();
+		if (_dirty.empty()) return;
+
+		// slot order is level order, so sorting groups dirty nodes by level
+		std::sort(_dirty.begin(), _dirty.end());
+
+		auto itDirty = _dirty.begin();
+		_frontier.clear();
+
+		for (size_t level = _depth[*itDirty]; level + 1 < _levelBegin.size();
+				 level++) {
+			const size_t levelEnd = _levelBegin[level + 1];
+
+			_next.clear();
+			// every child has exactly one parent in the frontier; dirty children are
+			// skipped here and picked up from the dirty list below
+			for (const size_t s : _frontier) {
+				for (size_t c = _firstChild[s]; c < _firstChild[s] + _childCount[s];
+						 c++) {
+					if (!_queued[c]) _next.push_back(c);
+				}
+			}
+			for (; itDirty != _dirty.end() && *itDirty < levelEnd; ++itDirty)
+				_next.push_back(*itDirty);
+
+			if (_next.empty()) {
+				if (itDirty == _dirty.end()) break;
+				level = _depth[*itDirty] - 1;
+				_frontier.clear();
+				continue;
+			}
+
+			computeSlots(_next);
+			std::swap(_frontier, _next);
+		}
+
+		_dirty.clear();
+	}
+
+	// Forces a full recomputation of every world matrix.
+	void invalidate() {
+		if (!_structureDirty) markRoots();
+	}
+
+	const Matrix &world(Node n) {
+		update();
+		return _world[_slotOf[n]];
+	}
+	const Matrix &inverseWorld(Node n) {
+		if (!_cacheInverses) setCacheInverses(true);
+		update();
+		return _inverse[_slotOf[n]];
+	}
+
+	// Direct access to the breadth-first ordered arrays, valid after update().
+	size_t        slot(Node n) const { return _slotOf[n]; }
+	Node          nodeAt(size_t slot) const { return _node[slot]; }
+	const Matrix *worldData() const { return _world.data(); }
+	const Matrix *inverseData() const { return _inverse.data(); }
+};
+
+typedef TransformHierarchy<float>  TransformHierarchyf;
+typedef TransformHierarchy<double> TransformHierarchyd;
+
+} // namespace alp
+
+extern template class alp::TransformHierarchy<float>;
+extern template class alp::TransformHierarchy<double>;
+#endif
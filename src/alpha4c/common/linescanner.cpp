@@ -36,6 +36,18 @@ lscan_t *lscan_new(const char *ptr, const char *end) {
 	return lscan;
 }
 
+lscan_t *lscan_open(const char *path) {
+	lscan_t *lscan = (lscan_t *)malloc(sizeof(lscan_t));
+
+	new (&lscan->ln) alp::LineScanner();
+	if (!lscan->ln.open(path)) {
+		lscan_free(lscan);
+		return nullptr;
+	}
+
+	return lscan;
+}
+
 void lscan_free(lscan_t *lscan) {
 	lscan->ln.~LineScanner();
 	free((void *)lscan);
@@ -44,7 +56,9 @@ void lscan_free(lscan_t *lscan) {
 char *lscan_str(lscan_t *lscan, int mode, int flags) {
 	std::string_view res;
 	bool             success = false;
+	const uint32_t   fuse    = lscan->ln.flags;
 
+	if (flags & LSCAN_FESCAPE) lscan->ln.flags |= alp::LineScanner::FUSE_ESCAPE;
 	switch (mode) {
 		case LSCAN_MANY: success = lscan->ln.getString(res); break;
 		case LSCAN_MINLINE: success = lscan->ln.getLnString(res); break;
@@ -53,16 +67,22 @@ char *lscan_str(lscan_t *lscan, int mode, int flags) {
 		case LSCAN_MLINE:
 			success = lscan->ln.getTrimmedLine(res, 0 != (flags & LSCAN_FREWIND));
 			break;
-		default: return nullptr;
+		default: break;
 	}
+	lscan->ln.flags = fuse;
 
 	if (!success) return nullptr;
 
 	if (res.size() < 1) return nullptr;
 
-	char *res_c = (char *)malloc(res.size() + 1);
-	memcpy(res_c, res.data(), res.size());
-	res_c[res.size()] = 0;
+	char * res_c = (char *)malloc(res.size() + 1);
+	size_t size  = res.size();
+	// unescaping never lengthens the string
+	if (lscan->ln.hasEscapes())
+		size = alp::unescape(res, res_c);
+	else
+		memcpy(res_c, res.data(), size);
+	res_c[size] = 0;
 
 	return res_c;
 }
@@ -71,7 +91,7 @@ int lscan_seekNewline(lscan_t *lscan, int alwaysAdvance) {
 	return lscan->ln.seekNewLine(alwaysAdvance != 0) ? 1 : 0;
 }
 size_t lscan_tell(lscan_t *lscan) { return lscan->ln.tell(); }
-size_t lscan_seek(lscan_t *lscan, int offset, int whence) {
+size_t lscan_seek(lscan_t *lscan, long long offset, int whence) {
 	return lscan->ln.seek(offset, whence);
 }
 int lscan_eof(lscan_t *lscan) { return lscan->ln.eof(); }
@@ -34,11 +34,12 @@ typedef struct lscan_t lscan_t;
 #define LSCAN_FREWIND 0x02
 
 lscan_t *lscan_new(const char *ptr, const char *end);
+lscan_t *lscan_open(const char *path);
 void     lscan_free(lscan_t *lscan);
 char *   lscan_str(lscan_t *lscan, int mode, int flags);
 int      lscan_seekNewline(lscan_t *lscan, int alwaysAdvance);
 size_t   lscan_tell(lscan_t *lscan);
-size_t   lscan_seek(lscan_t *lscan, int offset, int whence);
+size_t   lscan_seek(lscan_t *lscan, long long offset, int whence);
 int      lscan_eof(lscan_t *lscan);
 int      lscan_newline(lscan_t *lscan);
 
@@ -18,6 +18,7 @@ Alpha4. If not, see <https://www.gnu.org/licenses/>.
 #ifndef ALPHAC_COMMON_MATH_H
 #define ALPHAC_COMMON_MATH_H
 #include "alpha4c/common/inline.h"
+#include "alpha4c/common/random.h"
 #include <math.h>
 #include <stdlib.h>
 
@@ -27,6 +28,7 @@ ALPHA4C_INLINE(float fclamp)(float v) {
 	return v;
 }
 
-ALPHA4C_INLINE(float randf)() { return (float)rand() / (float)RAND_MAX; }
+/* Uniform in [0, 1) from the thread local generator. */
+ALPHA4C_INLINE(float randf)() { return rng_float(rng_thread()); }
 
 #endif
\ No newline at end of file
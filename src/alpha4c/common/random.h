@@ -0,0 +1,150 @@
+/* Copyright 2022 Peter Wagener <mail@peterwagener.net>
+
+This file is part of the Alpha4 library.
+
+Alpha4 is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Alpha4 is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Alpha4. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALPHA4C_COMMON_RANDOM_H
+#define ALPHA4C_COMMON_RANDOM_H
+#include "alpha4c/common/inline.h"
+#include "alpha4c/types/vector.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* xoshiro256++ generator (Blackman, Vigna). Streams are not synchronized, use
+ * rng_thread() or rng_split() to get one per thread. */
+typedef struct rng_t {
+	uint64_t s[4];
+} rng_t;
+
+ALPHA4C_INLINE(uint64_t rng_rotl)(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+/* Expands seed into a full state with splitmix64. */
+ALPHA4C_INLINE(void rng_seed)(rng_t *rng, uint64_t seed) {
+	for (int i = 0; i < 4; i++) {
+		uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+		z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z          = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		rng->s[i]  = z ^ (z >> 31);
+	}
+}
+
+ALPHA4C_INLINE(uint64_t rng_next)(rng_t *rng) {
+	uint64_t *     s   = rng->s;
+	const uint64_t res = rng_rotl(s[0] + s[3], 23) + s[0];
+	const uint64_t t   = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rng_rotl(s[3], 45);
+	return res;
+}
+
+ALPHA4C_INLINE(void rng_jumpBy)(rng_t *rng, const uint64_t *poly) {
+	uint64_t s[4] = {0, 0, 0, 0};
+	for (int i = 0; i < 4; i++) {
+		for (int b = 0; b < 64; b++) {
+			if (poly[i] & (1ull << b)) {
+				for (int k = 0; k < 4; k++)
+					s[k] ^= rng->s[k];
+			}
+			rng_next(rng);
+		}
+	}
+	for (int k = 0; k < 4; k++)
+		rng->s[k] = s[k];
+}
+
+/* Advances by 2^128 steps, giving 2^128 non-overlapping substreams. */
+ALPHA4C_INLINE(void rng_jump)(rng_t *rng) {
+	static const uint64_t poly[4] = {
+		0x180ec6d33cfd0abaull,
+		0xd5a61266f0c9392cull,
+		0xa9582618e03fc9aaull,
+		0x39abdc4529b1661cull};
+	rng_jumpBy(rng, poly);
+}
+
+/* Advances by 2^192 steps. */
+ALPHA4C_INLINE(void rng_longJump)(rng_t *rng) {
+	static const uint64_t poly[4] = {
+		0x76e15d3efefdcbbfull,
+		0xc5004e441c522fb3ull,
+		0x77710069854ee241ull,
+		0x39109bb02acbe635ull};
+	rng_jumpBy(rng, poly);
+}
+
+/* Uniform in [0, 1). */
+ALPHA4C_INLINE(float rng_float)(rng_t *rng) {
+	return (float)(rng_next(rng) >> 40) * (1.0f / 16777216.0f);
+}
+ALPHA4C_INLINE(double rng_double)(rng_t *rng) {
+	return (double)(rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Uniform in [0, n) without modulo bias (Lemire). */
+ALPHA4C_INLINE(uint32_t rng_range)(rng_t *rng, uint32_t n) {
+	uint64_t m = (rng_next(rng) >> 32) * n;
+	if ((uint32_t)m < n) {
+		const uint32_t t = (uint32_t)(-n) % n;
+		while ((uint32_t)m < t)
+			m = (rng_next(rng) >> 32) * n;
+	}
+	return (uint32_t)(m >> 32);
+}
+
+ALPHA4C_INLINE(vec3f_t rng_inBox)(
+	rng_t *rng, const vec3f_t *lo, const vec3f_t *hi) {
+	vec3f_t res = {
+		lo->x + (hi->x - lo->x) * rng_float(rng),
+		lo->y + (hi->y - lo->y) * rng_float(rng),
+		lo->z + (hi->z - lo->z) * rng_float(rng)};
+	return res;
+}
+ALPHA4C_INLINE(vec3f_t rng_inUnitBall)(rng_t *rng) {
+	vec3f_t res;
+	do {
+		res.x = 2 * rng_float(rng) - 1;
+		res.y = 2 * rng_float(rng) - 1;
+		res.z = 2 * rng_float(rng) - 1;
+	} while (vec3f_square(&res) > 1);
+	return res;
+}
+ALPHA4C_INLINE(vec3f_t rng_onUnitSphere)(rng_t *rng) {
+	const float z   = 2 * rng_float(rng) - 1;
+	const float phi = 6.28318530717958647692f * rng_float(rng);
+	const float r   = sqrtf(fmaxf(0.f, 1 - z * z));
+	vec3f_t     res = {r * cosf(phi), r * sinf(phi), z};
+	return res;
+}
+
+/* The following are implemented by the alpha4 library. */
+
+/* Splits a fresh substream off a process wide sequence seeded from the system
+ * entropy source, safe to call from any thread. */
+void rng_split(rng_t *rng);
+
+/* Generator private to the calling thread, created with rng_split(). */
+rng_t *rng_thread(void);
+
+void rng_fillFloat(rng_t *rng, float *res, size_t count);
+void rng_fillDouble(rng_t *rng, double *res, size_t count);
+
+#endif